@@ -45,11 +45,17 @@ int ChessBoard::getPieceAt(int side, u64 bitmapPos) {
 
 void ChessBoard::makeZobristKey() {
     chessboard[ZOBRISTKEY_IDX] = 0;
+    chessboard[PAWNKEY_IDX] = 0;
+    chessboard[MATERIALKEY_IDX] = 0;
     for (int u = 0; u < 12; u++) {
         u64 c = chessboard[u];
         while (c) {
             int position = BITScanForward(c);
             updateZobristKey(u, position);
+            chessboard[MATERIALKEY_IDX] += MATERIAL_WEIGHT[u];
+            if (u == PAWN_BLACK || u == PAWN_WHITE) {
+                updatePawnKey(u, position);
+            }
             RESET_LSB(c);
         }
     }
@@ -222,10 +228,15 @@ int ChessBoard::loadFen(string fen) {
         int p = s[63 - i];
         if (p != SQUARE_FREE) {
             updateZobristKey(p, i);
+            if (p == PAWN_BLACK || p == PAWN_WHITE) {
+                updatePawnKey(p, i);
+            }
+            chessboard[MATERIALKEY_IDX] += MATERIAL_WEIGHT[p];
             chessboard[p] |= POW2[i];
         } else {
             chessboard[p] &= NOTPOW2[i];
         }
+        mailbox[i] = (uchar) p;
     };
 
     for (unsigned e = 0; e < castle.length(); e++) {
@@ -266,6 +277,7 @@ int ChessBoard::loadFen(string fen) {
             break;
         }
     }
+    initOccupancy();
     return chessboard[SIDETOMOVE_IDX];
 }
 
@@ -279,4 +291,18 @@ bool ChessBoard::checkNPieces(std::unordered_map<int, int> pieces) {
     return a == 13;
 }
 
+// the occupancy and the mailbox agree with the piece bitboards
+bool ChessBoard::checkBoardState() {
+    _Tchessboard a;
+    uchar b[64];
+    memcpy(a, chessboard, sizeof(_Tchessboard));
+    memcpy(b, mailbox, sizeof(mailbox));
+    initOccupancy();
+    initMailbox();
+    const bool res = !memcmp(a, chessboard, sizeof(_Tchessboard)) && !memcmp(b, mailbox, sizeof(mailbox));
+    memcpy(chessboard, a, sizeof(_Tchessboard));
+    memcpy(mailbox, b, sizeof(mailbox));
+    return res;
+}
+
 #endif
\ No newline at end of file
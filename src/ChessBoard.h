@@ -53,6 +53,10 @@ public:
 #define ENPASSANT_IDX 13
 #define SIDETOMOVE_IDX 14
 #define ZOBRISTKEY_IDX 15
+#define PAWNKEY_IDX 16
+#define MATERIALKEY_IDX 17
+#define OCCUPANCY_IDX 18
+#define ALLPIECES_IDX 20
 
     ChessBoard();
 
@@ -108,11 +112,25 @@ public:
 
     bool checkNPieces(std::unordered_map<int, int>);
 
+    bool checkBoardState();
+
 #endif
 
+    // kept up to date by makemove and takeback
     template<int side>
     u64 getBitmap() const {//TODO cambiare nome
-        return chessboard[PAWN_BLACK + side] | chessboard[ROOK_BLACK + side] | chessboard[BISHOP_BLACK + side] | chessboard[KNIGHT_BLACK + side] | chessboard[KING_BLACK + side] | chessboard[QUEEN_BLACK + side];
+        return chessboard[OCCUPANCY_IDX + side];
+    }
+
+    u64 getAllPieces() const {
+        return chessboard[ALLPIECES_IDX];
+    }
+
+    void initOccupancy() {
+        for (int side = BLACK; side <= WHITE; side++) {
+            chessboard[OCCUPANCY_IDX + side] = chessboard[PAWN_BLACK + side] | chessboard[ROOK_BLACK + side] | chessboard[BISHOP_BLACK + side] | chessboard[KNIGHT_BLACK + side] | chessboard[KING_BLACK + side] | chessboard[QUEEN_BLACK + side];
+        }
+        chessboard[ALLPIECES_IDX] = chessboard[OCCUPANCY_IDX + BLACK] | chessboard[OCCUPANCY_IDX + WHITE];
     }
 
     void setSide(bool b) {
@@ -130,13 +148,33 @@ public:
 
     template<int side>
     int getPieceAt(const u64 bitmapPos) const {
-        return ((chessboard[PAWN_BLACK + side] & bitmapPos) ? PAWN_BLACK + side : ((chessboard[ROOK_BLACK + side] & bitmapPos) ? ROOK_BLACK + side : ((chessboard[BISHOP_BLACK + side] & bitmapPos) ? BISHOP_BLACK + side : ((chessboard[KNIGHT_BLACK + side] & bitmapPos) ? KNIGHT_BLACK + side : ((chessboard[QUEEN_BLACK + side] & bitmapPos) ? QUEEN_BLACK + side : ((chessboard[KING_BLACK + side] & bitmapPos) ? KING_BLACK + side : SQUARE_FREE))))));
+        ASSERT(bitmapPos);
+        const int piece = mailbox[BITScanForward(bitmapPos)];
+        return piece != SQUARE_FREE && (piece & 1) == side ? piece : SQUARE_FREE;
+    }
+
+    // the piece on the square of any side, SQUARE_FREE if empty
+    int getPieceOn(const int position) const {
+        ASSERT_RANGE(position, 0, 63);
+        return mailbox[position];
+    }
+
+    void initMailbox() {
+        memset(mailbox, SQUARE_FREE, sizeof(mailbox));
+        for (int piece = PAWN_BLACK; piece <= QUEEN_WHITE; piece++) {
+            for (u64 x = chessboard[piece]; x; RESET_LSB(x)) {
+                mailbox[BITScanForward(x)] = (uchar) piece;
+            }
+        }
     }
 
 protected:
 
     _Tchessboard chessboard;
 
+    // square to piece, kept in sync with the bitboards by makemove and takeback
+    uchar mailbox[64];
+
     typedef struct {
         u64 allPieces;
         u64 kingAttackers[2];
@@ -197,11 +235,6 @@ protected:
 
     void makeZobristKey();
 
-    template<int side>
-    int getNpiecesNoPawnNoKing() const {
-        return bitCount(chessboard[ROOK_BLACK + side] | chessboard[BISHOP_BLACK + side] | chessboard[KNIGHT_BLACK + side] | chessboard[QUEEN_BLACK + side]);
-    }
-
 #ifdef DEBUG_MODE
 
     void updateZobristKey(int piece, int position) {
@@ -210,10 +243,17 @@ protected:
         chessboard[ZOBRISTKEY_IDX] ^= _random::RANDOM_KEY[piece][position];
     }
 
+    void updatePawnKey(int piece, int position) {
+        ASSERT_RANGE(position, 0, 63);
+        ASSERT_RANGE(piece, PAWN_BLACK, PAWN_WHITE);
+        chessboard[PAWNKEY_IDX] ^= _random::RANDOM_KEY[piece][position];
+    }
+
     int getPieceAt(int side, u64 bitmapPos);
 
 #else
 #define updateZobristKey(piece, position) (chessboard[ZOBRISTKEY_IDX] ^= _random::RANDOM_KEY[piece][position])
+#define updatePawnKey(piece, position) (chessboard[PAWNKEY_IDX] ^= _random::RANDOM_KEY[piece][position])
 
 #endif
 private:
@@ -20,70 +20,148 @@
 
 using namespace _eval;
 
+Eval::_Tmaterial Eval::MATERIAL_TABLE[MATERIAL_TABLE_SIZE];
+mutex Eval::mutexMaterial;
+bool Eval::materialGenerated = false;
+
 Eval::Eval() {
+    {
+        std::lock_guard<std::mutex> lock(mutexMaterial);
+        if (!materialGenerated) {
+            static const int RADIX[12] = {9, 9, 3, 3, 3, 3, 3, 3, 1, 1, 2, 2};
+            for (int key = 0; key < MATERIAL_TABLE_SIZE; key++) {
+                int count[12];
+                for (int piece = PAWN_BLACK, k = key; piece <= QUEEN_WHITE; piece++) {
+                    count[piece] = k % RADIX[piece];
+                    k /= RADIX[piece];
+                }
+                setMaterial(MATERIAL_TABLE[key], count);
+            }
+            materialGenerated = true;
+        }
+    }
+    pawnHash = (_TpawnHash *) calloc(PAWN_HASH_SIZE, sizeof(_TpawnHash));
+    _assert(pawnHash);
+    evalHash = (u64 *) calloc(EVAL_HASH_SIZE, sizeof(u64));
+    _assert(evalHash);
 }
 
 Eval::~Eval() {
+    free(pawnHash);
+    free(evalHash);
+}
+
+void Eval::setMaterial(_Tmaterial &m, const int count[12]) {
+    int npieces = 0;
+    int total = 2;
+    int nonPawnValue[2];
+    for (int side = BLACK; side <= WHITE; side++) {
+        m.pieces[side] = (uchar) (count[ROOK_BLACK + side] + count[BISHOP_BLACK + side] + count[KNIGHT_BLACK + side] + count[QUEEN_BLACK + side]);
+        npieces += m.pieces[side];
+        total += m.pieces[side] + count[PAWN_BLACK + side];
+        nonPawnValue[side] = count[ROOK_BLACK + side] * VALUEROOK + count[BISHOP_BLACK + side] * VALUEBISHOP + count[KNIGHT_BLACK + side] * VALUEKNIGHT + count[QUEEN_BLACK + side] * VALUEQUEEN;
+        m.value[side] = (short) (count[PAWN_BLACK + side] * VALUEPAWN + nonPawnValue[side]);
+    }
+    m.phase = npieces < 4 ? END : npieces < 11 ? MIDDLE : OPEN;
+    for (int side = BLACK; side <= WHITE; side++) {
+        m.bishopPair[side] = m.phase != OPEN && count[BISHOP_BLACK + side] > 1;
+        // without pawns a minor piece more is not enough to win
+        m.scale[side] = MATERIAL_SCALE_NORMAL;
+        if (!count[PAWN_BLACK + side]) {
+            if (nonPawnValue[side] < VALUEROOK) {
+                m.scale[side] = 0;
+            } else if (nonPawnValue[side] - nonPawnValue[side ^ 1] <= VALUEBISHOP) {
+                m.scale[side] = MATERIAL_SCALE_DRAWISH;
+            }
+        }
+    }
+
+    //regexp: KN?B*KB*
+    m.flags = 0;
+    if (total == 2) {
+        m.flags = MATERIAL_DRAW;
+    } else if (total <= 6 && !count[PAWN_BLACK] && !count[PAWN_WHITE] && !count[ROOK_BLACK] && !count[ROOK_WHITE] && !count[QUEEN_BLACK] && !count[QUEEN_WHITE]) {
+        const int nBishop = count[BISHOP_BLACK] + count[BISHOP_WHITE];
+        const int nKnight = count[KNIGHT_BLACK] + count[KNIGHT_WHITE];
+        if (!nKnight) {
+            //regexp: KB+KB*, more than one bishop needs the square colours
+            m.flags = nBishop == 1 ? MATERIAL_DRAW : MATERIAL_BISHOPS_ONLY;
+        } else if (!nBishop && nKnight < 3) {
+            //KNKN*
+            m.flags = MATERIAL_DRAW;
+        }
+    }
+}
+
+const Eval::_Tmaterial &Eval::getMaterialOverflow() {
+    int count[12];
+    for (int piece = PAWN_BLACK; piece <= QUEEN_WHITE; piece++) {
+        count[piece] = bitCount(chessboard[piece]);
+    }
+    setMaterial(materialOverflow, count);
+    return materialOverflow;
 }
 
 template<int side>
 void Eval::openFile() {
-    u64 side_rooks = chessboard[ROOK_BLACK + side];
-    structureEval.openFile = 0;
-    structureEval.semiOpenFile[side] = 0;
-    while (side_rooks) {
-        int o = BITScanForward(side_rooks);
-        if (!(FILE_[o] & (chessboard[WHITE] | chessboard[BLACK]))) {
-            structureEval.openFile |= FILE_[o];
-        } else if (FILE_[o] & chessboard[side ^ 1]) {
-            structureEval.semiOpenFile[side] |= FILE_[o];
-        }
-        RESET_LSB(side_rooks);
+    const u64 rookFiles = fileFill(chessboard[ROOK_BLACK + side]);
+    const u64 open = ~(pawnEntry->pawnFiles[WHITE] | pawnEntry->pawnFiles[BLACK]);
+    structureEval.openFile = rookFiles & open;
+    structureEval.semiOpenFile[side] = rookFiles & pawnEntry->pawnFiles[side ^ 1];
+}
+
+void Eval::probePawnHash() {
+    const u64 key = chessboard[PAWNKEY_IDX];
+#ifdef DEBUG_MODE
+    u64 k = 0;
+    for (int side = BLACK; side <= WHITE; side++) {
+        for (u64 p = chessboard[side]; p; RESET_LSB(p)) {
+            k ^= _random::RANDOM_KEY[side][BITScanForward(p)];
+        }
     }
+    ASSERT(k == key);
+#endif
+    _TpawnHash *entry = &pawnHash[key & (PAWN_HASH_SIZE - 1)];
+    if (entry->key != key) {
+        entry->key = key;
+        entry->score[BLACK] = evaluatePawnStructure<BLACK>(entry->isolated[BLACK]);
+        entry->score[WHITE] = evaluatePawnStructure<WHITE>(entry->isolated[WHITE]);
+        entry->pawnFiles[BLACK] = fileFill(chessboard[PAWN_BLACK]);
+        entry->pawnFiles[WHITE] = fileFill(chessboard[PAWN_WHITE]);
+    }
+#ifdef DEBUG_MODE
+    else {
+        // the hit must match the evaluation
+        u64 isolated[2];
+        const int score[2] = {evaluatePawnStructure<BLACK>(isolated[BLACK]), evaluatePawnStructure<WHITE>(isolated[WHITE])};
+        for (int side = BLACK; side <= WHITE; side++) {
+            ASSERT(entry->score[side] == score[side]);
+            ASSERT(entry->isolated[side] == isolated[side]);
+            ASSERT(entry->pawnFiles[side] == fileFill(chessboard[PAWN_BLACK + side]));
+        }
+    }
+#endif
+    pawnEntry = entry;
+    structureEval.isolated[BLACK] = entry->isolated[BLACK];
+    structureEval.isolated[WHITE] = entry->isolated[WHITE];
 }
 
-template<int side, Eval::_Tphase phase>
-int Eval::evaluatePawn() {
-    INC(evaluationCount[side]);
+template<int side>
+int Eval::evaluatePawnStructure(u64 &isolated) {
     u64 ped_friends = chessboard[side];
+    isolated = 0;
     if (!ped_friends) {
-        ADD(SCORE_DEBUG.NO_PAWNS[side], -NO_PAWNS);
-        return -NO_PAWNS;
+        return 0;
     }
-    structureEval.isolated[side] = 0;
-    int result = MOB_PAWNS[getMobilityPawns(side, chessboard[ENPASSANT_IDX], ped_friends, side == WHITE ? structureEval.allPiecesSide[BLACK] : structureEval.allPiecesSide[WHITE], ~structureEval.allPiecesSide[BLACK] | ~structureEval.allPiecesSide[WHITE])];
-    ADD(SCORE_DEBUG.MOB_PAWNS[side], result);
+    int result = 0;
     if (bitCount(chessboard[side ^ 1]) == 8) {
         result -= ENEMIES_PAWNS_ALL;
         ADD(SCORE_DEBUG.ENEMIES_PAWNS_ALL[side], -ENEMIES_PAWNS_ALL);
     }
-    result += ATTACK_KING * bitCount(ped_friends & structureEval.kingAttackers[side ^ 1]);
-    ADD(SCORE_DEBUG.ATTACK_KING_PAWN[side], ATTACK_KING * bitCount(ped_friends & structureEval.kingAttackers[side ^ 1]));
-    //space
-    if (phase == OPEN) {
-        result += PAWN_CENTER * bitCount(ped_friends & CENTER_MASK);
-        ADD(SCORE_DEBUG.PAWN_CENTER[side], PAWN_CENTER * bitCount(ped_friends & CENTER_MASK));
-    }
     u64 p = ped_friends;
     while (p) {
         int o = BITScanForward(p);
         u64 pos = POW2[o];
-        if (phase != OPEN) {
-            structureEval.kingSecurityDistance[side] += FRIEND_NEAR_KING * (NEAR_MASK2[structureEval.posKing[side]] & pos ? 1 : 0);
-            structureEval.kingSecurityDistance[side] -= ENEMY_NEAR_KING * (NEAR_MASK2[structureEval.posKing[side ^ 1]] & pos ? 1 : 0);
-            ///  pawn in race
-            if (PAWNS_7_2[side] & pos) {
-                result += PAWN_7H;
-                ADD(SCORE_DEBUG.PAWN_7H[side], PAWN_7H);
-                if (((shiftForward<side, 8>(pos) & (~structureEval.allPieces)) || (structureEval.allPiecesSide[side ^ 1] & PAWN_FORK_MASK[side][o]))) {
-                    result += PAWN_IN_RACE;
-                    ADD(SCORE_DEBUG.PAWN_IN_RACE[side], PAWN_IN_RACE);
-                }
-            }
-        }
-        /// blocked
-        result -= (!(PAWN_FORK_MASK[side][o] & structureEval.allPiecesSide[side ^ 1])) && (structureEval.allPieces & (shiftForward<side, 8>(pos))) ? PAWN_BLOCKED : 0;
-        ADD(SCORE_DEBUG.PAWN_BLOCKED[side], (!(PAWN_FORK_MASK[side][o] & structureEval.allPiecesSide[side ^ 1])) && (structureEval.allPieces & (shiftForward<side, 8>(pos))) ? -PAWN_BLOCKED : 0);
         /// unprotected
         if (!(ped_friends & PAWN_PROTECTED_MASK[side][o])) {
             result -= UNPROTECTED_PAWNS;
@@ -93,14 +171,14 @@ int Eval::evaluatePawn() {
         if (!(ped_friends & PAWN_ISOLATED_MASK[o])) {
             result -= PAWN_ISOLATED;
             ADD(SCORE_DEBUG.PAWN_ISOLATED[side], -PAWN_ISOLATED);
-            structureEval.isolated[side] |= pos;
+            isolated |= pos;
         }
         /// doubled
         if (NOTPOW2[o] & FILE_[o] & ped_friends) {
             result -= DOUBLED_PAWNS;
             ADD(SCORE_DEBUG.DOUBLED_PAWNS[side], -DOUBLED_PAWNS);
             /// doubled and isolated
-            if (!(structureEval.isolated[side] & pos)) {
+            if (!(isolated & pos)) {
                 ADD(SCORE_DEBUG.DOUBLED_ISOLATED_PAWNS[side], -DOUBLED_ISOLATED_PAWNS);
                 result -= DOUBLED_ISOLATED_PAWNS;
             }
@@ -120,6 +198,49 @@ int Eval::evaluatePawn() {
     return result;
 }
 
+template<int side, Eval::_Tphase phase>
+int Eval::evaluatePawn() {
+    INC(evaluationCount[side]);
+    u64 ped_friends = chessboard[side];
+    if (!ped_friends) {
+        ADD(SCORE_DEBUG.NO_PAWNS[side], -NO_PAWNS);
+        return -NO_PAWNS;
+    }
+    int result = MOB_PAWNS[getMobilityPawns(side, chessboard[ENPASSANT_IDX], ped_friends, side == WHITE ? structureEval.allPiecesSide[BLACK] : structureEval.allPiecesSide[WHITE], ~structureEval.allPiecesSide[BLACK] | ~structureEval.allPiecesSide[WHITE])];
+    ADD(SCORE_DEBUG.MOB_PAWNS[side], result);
+    result += pawnEntry->score[side];
+    result += ATTACK_KING * bitCount(ped_friends & structureEval.kingAttackers[side ^ 1]);
+    ADD(SCORE_DEBUG.ATTACK_KING_PAWN[side], ATTACK_KING * bitCount(ped_friends & structureEval.kingAttackers[side ^ 1]));
+    //space
+    if (phase == OPEN) {
+        result += PAWN_CENTER * bitCount(ped_friends & CENTER_MASK);
+        ADD(SCORE_DEBUG.PAWN_CENTER[side], PAWN_CENTER * bitCount(ped_friends & CENTER_MASK));
+    }
+    u64 p = ped_friends;
+    while (p) {
+        int o = BITScanForward(p);
+        u64 pos = POW2[o];
+        if (phase != OPEN) {
+            structureEval.kingSecurityDistance[side] += FRIEND_NEAR_KING * (NEAR_MASK2[structureEval.posKing[side]] & pos ? 1 : 0);
+            structureEval.kingSecurityDistance[side] -= ENEMY_NEAR_KING * (NEAR_MASK2[structureEval.posKing[side ^ 1]] & pos ? 1 : 0);
+            ///  pawn in race
+            if (PAWNS_7_2[side] & pos) {
+                result += PAWN_7H;
+                ADD(SCORE_DEBUG.PAWN_7H[side], PAWN_7H);
+                if (((shiftForward<side, 8>(pos) & (~structureEval.allPieces)) || (structureEval.allPiecesSide[side ^ 1] & PAWN_FORK_MASK[side][o]))) {
+                    result += PAWN_IN_RACE;
+                    ADD(SCORE_DEBUG.PAWN_IN_RACE[side], PAWN_IN_RACE);
+                }
+            }
+        }
+        /// blocked
+        result -= (!(PAWN_FORK_MASK[side][o] & structureEval.allPiecesSide[side ^ 1])) && (structureEval.allPieces & (shiftForward<side, 8>(pos))) ? PAWN_BLOCKED : 0;
+        ADD(SCORE_DEBUG.PAWN_BLOCKED[side], (!(PAWN_FORK_MASK[side][o] & structureEval.allPiecesSide[side ^ 1])) && (structureEval.allPieces & (shiftForward<side, 8>(pos))) ? -PAWN_BLOCKED : 0);
+        RESET_LSB(p);
+    }
+    return result;
+}
+
 template<int side, Eval::_Tphase phase>
 int Eval::evaluateBishop(u64 enemies, u64 friends) {
     INC(evaluationCount[side]);
@@ -128,7 +249,7 @@ int Eval::evaluateBishop(u64 enemies, u64 friends) {
         return 0;
     }
     int result = 0;
-    if (phase != OPEN && bitCount(x) > 1) {
+    if (material->bishopPair[side]) {
         result += BONUS2BISHOP;
         ADD(SCORE_DEBUG.BONUS2BISHOP[side], BONUS2BISHOP);
     }
@@ -377,41 +498,53 @@ int Eval::evaluateKing(int side, u64 squares) {
 
 int Eval::getScore(const int side, const int N_PIECE, const int alpha, const int beta, const bool trace) {
 
-    int lazyscore_white = lazyEvalSide<WHITE>();
-    int lazyscore_black = lazyEvalSide<BLACK>();
+    material = &getMaterial();
+    int lazyscore_white = material->value[WHITE];
+    int lazyscore_black = material->value[BLACK];
     int lazyscore = lazyscore_black - lazyscore_white;
     if (side) {
         lazyscore = -lazyscore;
     }
     if (lazyscore > (beta + FUTIL_MARGIN) || lazyscore < (alpha - FUTIL_MARGIN)) {
         INC(lazyEvalCuts);
+        evalStats.lazy++;
         return lazyscore;
     }
 
+    // only full evaluations are cached, a lazy score depends on alpha/beta.
+    // The en passant square is mixed in explicitly: the move generator clears it
+    // without restoring it on takeback, so it is not always in sync with the zobrist key
+    const u64 evalKey = chessboard[ZOBRISTKEY_IDX] ^ _random::RANDSIDE[side] ^ ((chessboard[ENPASSANT_IDX] + 1) * 0x9e3779b97f4a7c15ULL);
+    u64 *evalEntry = &evalHash[evalKey & (EVAL_HASH_SIZE - 1)];
+    const u64 cached = *evalEntry;
+    evalStats.probe++;
+    const bool evalHit = ((cached ^ evalKey) & ~EVAL_HASH_SCORE_MASK) == 0;
+    if (evalHit) {
+        evalStats.hit++;
+#ifndef DEBUG_MODE
+        if (!trace) {
+            return (short) (cached & EVAL_HASH_SCORE_MASK);
+        }
+#endif
+    }
+
 #ifdef DEBUG_MODE
     evaluationCount[WHITE] = evaluationCount[BLACK] = 0;
     memset(&SCORE_DEBUG, 0, sizeof(_TSCORE_DEBUG));
 #endif
     memset(structureEval.kingSecurityDistance, 0, sizeof(structureEval.kingSecurityDistance));
-    int npieces = getNpiecesNoPawnNoKing<WHITE>() + getNpiecesNoPawnNoKing<BLACK>();
-    _Tphase phase;
-    if (npieces < 4) {
-        phase = END;
-    } else if (npieces < 11) {
-        phase = MIDDLE;
-    } else {
-        phase = OPEN;
-    }
+    const _Tphase phase = (_Tphase) material->phase;
     structureEval.allPiecesNoPawns[BLACK] = getBitmapNoPawns<BLACK>();
     structureEval.allPiecesNoPawns[WHITE] = getBitmapNoPawns<WHITE>();
-    structureEval.allPiecesSide[BLACK] = structureEval.allPiecesNoPawns[BLACK] | chessboard[PAWN_BLACK];
-    structureEval.allPiecesSide[WHITE] = structureEval.allPiecesNoPawns[WHITE] | chessboard[PAWN_WHITE];
-    structureEval.allPieces = structureEval.allPiecesSide[BLACK] | structureEval.allPiecesSide[WHITE];
+    structureEval.allPiecesSide[BLACK] = getBitmap<BLACK>();
+    structureEval.allPiecesSide[WHITE] = getBitmap<WHITE>();
+    structureEval.allPieces = getAllPieces();
     structureEval.posKing[BLACK] = (uchar) BITScanForward(chessboard[KING_BLACK]);
     structureEval.posKing[WHITE] = (uchar) BITScanForward(chessboard[KING_WHITE]);
     structureEval.kingAttackers[WHITE] = getAllAttackers<WHITE>(structureEval.posKing[WHITE], structureEval.allPieces);
     structureEval.kingAttackers[BLACK] = getAllAttackers<BLACK>(structureEval.posKing[BLACK], structureEval.allPieces);
 
+    probePawnHash();
     openFile<WHITE>();
     openFile<BLACK>();
     int bonus_attack_king_black = 0;
@@ -531,6 +664,11 @@ int Eval::getScore(const int side, const int N_PIECE, const int alpha, const int
         cout << endl;
     }
 #endif
-    return side ? -result : result;
+    // result is black - white, scaled down when the favoured side lacks the material to win
+    result = result * material->scale[result > 0 ? BLACK : WHITE] / MATERIAL_SCALE_NORMAL;
+    result = side ? -result : result;
+    ASSERT(!evalHit || result == (short) (cached & EVAL_HASH_SCORE_MASK));
+    *evalEntry = (evalKey & ~EVAL_HASH_SCORE_MASK) | (unsigned short) result;
+    return result;
 }
 
@@ -40,6 +40,12 @@ public:
         return lazyEvalSide<side>() - lazyEvalSide<side ^ 1>();
     }
 
+    typedef struct {
+        u64 probe, hit, lazy;
+    } _TevalStats;
+
+    _TevalStats evalStats = {};
+
 #ifdef DEBUG_MODE
     unsigned lazyEvalCuts;
 #endif
@@ -76,6 +82,36 @@ protected:
     STATIC_CONST int ROOK_TRAPPED = 6;
     STATIC_CONST int UNDEVELOPED = 4;
     STATIC_CONST int UNDEVELOPED_BISHOP = 4;
+
+    static const uchar MATERIAL_DRAW = 1;
+    static const uchar MATERIAL_BISHOPS_ONLY = 2;
+    static const int MATERIAL_SCALE_NORMAL = 16;
+    static const int MATERIAL_SCALE_DRAWISH = 4;
+
+    // everything that depends only on the piece counts, indexed by chessboard[MATERIALKEY_IDX]
+    typedef struct {
+        uchar phase;
+        uchar flags;
+        uchar pieces[2];        // no pawns no king
+        bool bishopPair[2];     // BONUS2BISHOP applies
+        uchar scale[2];         // sixteenths of the score when it favours that side
+        short value[2];
+    } _Tmaterial;
+
+    const _Tmaterial &getMaterial() {
+        const u64 key = chessboard[MATERIALKEY_IDX];
+#ifdef DEBUG_MODE
+        u64 k = 0;
+        for (int piece = PAWN_BLACK; piece <= QUEEN_WHITE; piece++) {
+            k += bitCount(chessboard[piece]) * MATERIAL_WEIGHT[piece];
+        }
+        ASSERT(k == key);
+#endif
+        if (!((key + MATERIAL_OVERFLOW_ADD) & MATERIAL_OVERFLOW_MASK)) {
+            return MATERIAL_TABLE[(unsigned) key];
+        }
+        return getMaterialOverflow();
+    }
 #ifdef DEBUG_MODE
     typedef struct {
         int BAD_BISHOP[2];
@@ -135,6 +171,36 @@ private:
         OPEN, MIDDLE, END
     };
 
+    // pawn structure terms that depend only on the pawns, indexed by chessboard[PAWNKEY_IDX]
+    typedef struct {
+        u64 key;
+        u64 isolated[2];
+        u64 pawnFiles[2];
+        int score[2];
+    } _TpawnHash;
+
+    static const int PAWN_HASH_SIZE = 0x4000;
+
+    _TpawnHash *pawnHash;
+    const _TpawnHash *pawnEntry;
+
+    // full getScore result, the low 16 bits hold the score and the rest the key
+    static const int EVAL_HASH_SIZE = 0x10000;
+    static const u64 EVAL_HASH_SCORE_MASK = 0xffffULL;
+
+    u64 *evalHash;
+
+    static _Tmaterial MATERIAL_TABLE[MATERIAL_TABLE_SIZE];
+    static mutex mutexMaterial;
+    static bool materialGenerated;
+    // promoted pieces beyond the table range
+    _Tmaterial materialOverflow;
+    const _Tmaterial *material;
+
+    static void setMaterial(_Tmaterial &, const int count[12]);
+
+    const _Tmaterial &getMaterialOverflow();
+
     typedef struct {
         int pawns[2];
         int bishop[2];
@@ -170,6 +236,21 @@ private:
     template<int side, _Tphase phase>
     int evaluatePawn();
 
+    template<int side>
+    int evaluatePawnStructure(u64 &isolated);
+
+    void probePawnHash();
+
+    static u64 fileFill(u64 b) {
+        b |= b << 8;
+        b |= b << 16;
+        b |= b << 32;
+        b |= b >> 8;
+        b |= b >> 16;
+        b |= b >> 32;
+        return b;
+    }
+
     template<int side, _Tphase phase>
     int evaluateBishop(const u64, u64);
 
@@ -187,7 +268,7 @@ private:
 
     template<int side>
     int lazyEvalSide() {
-        return bitCount(chessboard[PAWN_BLACK + side]) * VALUEPAWN + bitCount(chessboard[ROOK_BLACK + side]) * VALUEROOK + bitCount(chessboard[BISHOP_BLACK + side]) * VALUEBISHOP + bitCount(chessboard[KNIGHT_BLACK + side]) * VALUEKNIGHT + bitCount(chessboard[QUEEN_BLACK + side]) * VALUEQUEEN;
+        return getMaterial().value[side];
     }
 
     void generateLinkRook();
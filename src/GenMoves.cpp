@@ -21,18 +21,21 @@
 #include "util/Bitboard.h"
 
 bool GenMoves::forceCheck = false;
+constexpr int GenMoves::SEE_ORDER[6];
 
 GenMoves::GenMoves() : perftMode(false), listId(-1) {
     currentPly = 0;
-    gen_list = (_TmoveP *) calloc(MAX_PLY, sizeof(_TmoveP));
-    _assert(gen_list);
+    arena = (_Tarena *) calloc(1, sizeof(_Tarena));
+    _assert(arena);
+    gen_list = arena->genList;
     for (int i = 0; i < MAX_PLY; i++) {
-        gen_list[i].moveList = (_Tmove *) calloc(MAX_MOVE, sizeof(_Tmove));
-        _assert(gen_list[i].moveList);
+        gen_list[i].moveList = arena->moveList[i];
+        gen_list[i].score = arena->score[i];
     }
-    repetitionMap = (u64 *) malloc(sizeof(u64) * MAX_REP_COUNT);
-    _assert(repetitionMap);
+    pvStack = arena->pvStack;
+    repetitionMap = arena->repetitionMap;
     repetitionMapCount = 0;
+    memset(killers, 0, sizeof(killers));
 }
 
 bool GenMoves::performRankFileCapture(const int piece, const u64 enemies, const int side, const u64 allpieces) {
@@ -118,6 +121,10 @@ bool GenMoves::generateCaptures(const int side, const u64 enemies, const u64 fri
     return side ? generateCaptures<WHITE>(enemies, friends) : generateCaptures<BLACK>(enemies, friends);
 }
 
+int GenMoves::countLegalMoves() {
+    return getSide() ? countLegalMoves<WHITE>() : countLegalMoves<BLACK>();
+}
+
 int GenMoves::getMobilityPawns(const int side, const int ep, const u64 ped_friends, const u64 enemies, const u64 xallpieces) {
     ASSERT_RANGE(side, 0, 1);
     return ep == NO_ENPASSANT ? 0 : bitCount(ENPASSANT_MASK[side ^ 1][ep] & chessboard[side]) + side == WHITE ? bitCount((ped_friends << 8) & xallpieces) + bitCount(((((ped_friends & TABJUMPPAWN) << 8) & xallpieces) << 8) & xallpieces) + bitCount((chessboard[side] << 7) & TABCAPTUREPAWN_LEFT & enemies) + bitCount((chessboard[side] << 9) & TABCAPTUREPAWN_RIGHT & enemies) : bitCount((ped_friends >> 8) & xallpieces) + bitCount(((((ped_friends & TABJUMPPAWN) >> 8) & xallpieces) >> 8) & xallpieces) + bitCount((chessboard[side] >> 7) & TABCAPTUREPAWN_RIGHT & enemies) + bitCount((chessboard[side] >> 9) & TABCAPTUREPAWN_LEFT & enemies);
@@ -140,40 +147,97 @@ void GenMoves::setPerft(const bool b) {
 
 void GenMoves::clearKillerHeuristic() {
     memset(killerHeuristic, 0, sizeof(killerHeuristic));
+    memset(killers, 0, sizeof(killers));
 }
 
-_Tmove *GenMoves::getNextMove(_TmoveP *list) {
-    _Tmove *gen_list1 = list->moveList;
-    ASSERT(gen_list1);
-    int listcount = list->size;
-    int bestId = -1;
-    int j, bestScore;
-    for (j = 0; j < listcount; j++) {
-        if (!gen_list1[j].used) {
-            bestId = j;
-            bestScore = gen_list1[bestId].score;
-            break;
-        }
+string GenMoves::packedMoveToString(const _TpackedMove packed) {
+    string s = BOARD[packed & 0x3f] + BOARD[(packed >> 6) & 0x3f];
+    if ((packed >> 14) == PACKED_PROMOTION) {
+        s += "nbrq"[(packed >> 12) & 0x3];
+    }
+    return s;
+}
+
+bool GenMoves::unpackMove(const _TpackedMove packed, _Tmove *move) {
+    return isPseudoLegal(packed, move) && isLegal(move);
+}
+
+bool GenMoves::isPseudoLegal(const _TpackedMove packed, _Tmove *move) {
+    incListId();
+    const int side = getSide();
+    bool res;
+    if (side) {
+        const u64 friends = getBitmap<WHITE>();
+        setLegalMask<WHITE>(friends, getAllPieces());
+        res = isPseudoLegal<WHITE>(packed, move);
+    } else {
+        const u64 friends = getBitmap<BLACK>();
+        setLegalMask<BLACK>(friends, getAllPieces());
+        res = isPseudoLegal<BLACK>(packed, move);
     }
-    if (bestId == -1) {
+    decListId();
+    return res;
+}
+
+bool GenMoves::isLegal(const _Tmove *move) {
+    incListId();
+    const int side = getSide();
+    bool res;
+    if (side) {
+        const u64 friends = getBitmap<WHITE>();
+        setLegalMask<WHITE>(friends, getAllPieces());
+        res = isLegal<WHITE>(move);
+    } else {
+        const u64 friends = getBitmap<BLACK>();
+        setLegalMask<BLACK>(friends, getAllPieces());
+        res = isLegal<BLACK>(move);
+    }
+    decListId();
+    return res;
+}
+
+// swap-to-front selection for the first picks, then an insertion sort of the rest of the range
+_Tmove *GenMoves::getNextMove(_TmoveP *list, _TpickRange &range, const bool goodCaptures) {
+    int *score = list->score;
+    _Tmove *moveList = list->moveList;
+    ASSERT(score);
+    const int cursor = range.cursor;
+    if (cursor >= range.end) {
         return nullptr;
     }
-    for (int i = j + 1; i < listcount; i++) {
-        if (!gen_list1[i].used && gen_list1[i].score > bestScore) {
-            bestId = i;
-            bestScore = gen_list1[bestId].score;
+    if (range.nPicked < PICKS_BEFORE_SORT) {
+        int bestId = cursor;
+        for (int i = cursor + 1; i < range.end; i++) {
+            if (score[i] > score[bestId]) {
+                bestId = i;
+            }
         }
+        if (bestId != cursor) {
+            std::swap(score[bestId], score[cursor]);
+            std::swap(moveList[bestId], moveList[cursor]);
+        }
+    } else if (range.nPicked == PICKS_BEFORE_SORT) {
+        for (int i = cursor + 1; i < range.end; i++) {
+            const int sc = score[i];
+            const _Tmove move = moveList[i];
+            int j = i - 1;
+            for (; j >= cursor && score[j] < sc; j--) {
+                score[j + 1] = score[j];
+                moveList[j + 1] = moveList[j];
+            }
+            score[j + 1] = sc;
+            moveList[j + 1] = move;
+        }
+    }
+    if (goodCaptures && score[cursor] < 0) {
+        return nullptr;
     }
-    gen_list1[bestId].used = true;
-    return &gen_list1[bestId];
+    range.nPicked++;
+    return &moveList[range.cursor++];
 }
 
 GenMoves::~GenMoves() {
-    for (int i = 0; i < MAX_PLY; i++) {
-        free(gen_list[i].moveList);
-    }
-    free(gen_list);
-    free(repetitionMap);
+    free(arena);
 }
 
 void GenMoves::performCastle(const int side, const uchar type) {
@@ -190,6 +254,7 @@ void GenMoves::performCastle(const int side, const uchar type) {
             updateZobristKey(ROOK_WHITE, 2);
             updateZobristKey(ROOK_WHITE, 0);
             chessboard[ROOK_WHITE] = (chessboard[ROOK_WHITE] | POW2_2) & NOTPOW2_0;
+            moveMailbox(3, 1, 0, 2);
         } else {
             ASSERT(type & QUEEN_SIDE_CASTLE_MOVE_MASK);
             ASSERT(getPieceAt(side, POW2_3) == KING_WHITE);
@@ -203,6 +268,7 @@ void GenMoves::performCastle(const int side, const uchar type) {
             chessboard[ROOK_WHITE] = (chessboard[ROOK_WHITE] | POW2_4) & NOTPOW2_7;
             updateZobristKey(ROOK_WHITE, 4);
             updateZobristKey(ROOK_WHITE, 7);
+            moveMailbox(3, 5, 7, 4);
         }
     } else {
         if (type & KING_SIDE_CASTLE_MOVE_MASK) {
@@ -216,6 +282,7 @@ void GenMoves::performCastle(const int side, const uchar type) {
             chessboard[ROOK_BLACK] = (chessboard[ROOK_BLACK] | POW2_58) & NOTPOW2_56;
             updateZobristKey(ROOK_BLACK, 58);
             updateZobristKey(ROOK_BLACK, 56);
+            moveMailbox(59, 57, 56, 58);
         } else {
             ASSERT(type & QUEEN_SIDE_CASTLE_MOVE_MASK);
             ASSERT(getPieceAt(side, POW2_59) == KING_BLACK);
@@ -229,6 +296,7 @@ void GenMoves::performCastle(const int side, const uchar type) {
             chessboard[ROOK_BLACK] = (chessboard[ROOK_BLACK] | POW2_60) & NOTPOW2_63;
             updateZobristKey(ROOK_BLACK, 60);
             updateZobristKey(ROOK_BLACK, 63);
+            moveMailbox(59, 61, 63, 60);
         }
     }
 }
@@ -254,22 +322,29 @@ int GenMoves::getMobilityCastle(const int side, const u64 allpieces) {
     return count;
 }
 
-void GenMoves::tryAllCastle(const int side, const u64 allpieces) {
+bool GenMoves::isCastleAllowed(const int side, const uchar type, const u64 allpieces) {
     ASSERT_RANGE(side, 0, 1);
     if (side == WHITE) {
-        if (POW2_3 & chessboard[KING_WHITE] && !(allpieces & 0x6ULL) && chessboard[RIGHT_CASTLE_IDX] & RIGHT_KING_CASTLE_WHITE_MASK && chessboard[ROOK_WHITE] & POW2_0 && !isAttacked<WHITE>(1, allpieces) && !isAttacked<WHITE>(2, allpieces) && !isAttacked<WHITE>(3, allpieces)) {
-            pushmove<KING_SIDE_CASTLE_MOVE_MASK>(-1, -1, WHITE, NO_PROMOTION, -1);
-        }
-        if (POW2_3 & chessboard[KING_WHITE] && !(allpieces & 0x70ULL) && chessboard[RIGHT_CASTLE_IDX] & RIGHT_QUEEN_CASTLE_WHITE_MASK && chessboard[ROOK_WHITE] & POW2_7 && !isAttacked<WHITE>(3, allpieces) && !isAttacked<WHITE>(4, allpieces) && !isAttacked<WHITE>(5, allpieces)) {
-            pushmove<QUEEN_SIDE_CASTLE_MOVE_MASK>(-1, -1, WHITE, NO_PROMOTION, -1);
-        }
-    } else {
-        if (POW2_59 & chessboard[KING_BLACK] && chessboard[RIGHT_CASTLE_IDX] & RIGHT_KING_CASTLE_BLACK_MASK && !(allpieces & 0x600000000000000ULL) && chessboard[ROOK_BLACK] & POW2_56 && !isAttacked<BLACK>(57, allpieces) && !isAttacked<BLACK>(58, allpieces) && !isAttacked<BLACK>(59, allpieces)) {
-            pushmove<KING_SIDE_CASTLE_MOVE_MASK>(-1, -1, BLACK, NO_PROMOTION, -1);
-        }
-        if (POW2_59 & chessboard[KING_BLACK] && chessboard[RIGHT_CASTLE_IDX] & RIGHT_QUEEN_CASTLE_BLACK_MASK && !(allpieces & 0x7000000000000000ULL) && chessboard[ROOK_BLACK] & POW2_63 && !isAttacked<BLACK>(59, allpieces) && !isAttacked<BLACK>(60, allpieces) && !isAttacked<BLACK>(61, allpieces)) {
-            pushmove<QUEEN_SIDE_CASTLE_MOVE_MASK>(-1, -1, BLACK, NO_PROMOTION, -1);
+        if (type & KING_SIDE_CASTLE_MOVE_MASK) {
+            return POW2_3 & chessboard[KING_WHITE] && !(allpieces & 0x6ULL) && chessboard[RIGHT_CASTLE_IDX] & RIGHT_KING_CASTLE_WHITE_MASK && chessboard[ROOK_WHITE] & POW2_0 && !isAttacked<WHITE>(1, allpieces) && !isAttacked<WHITE>(2, allpieces) && !isAttacked<WHITE>(3, allpieces);
         }
+        return POW2_3 & chessboard[KING_WHITE] && !(allpieces & 0x70ULL) && chessboard[RIGHT_CASTLE_IDX] & RIGHT_QUEEN_CASTLE_WHITE_MASK && chessboard[ROOK_WHITE] & POW2_7 && !isAttacked<WHITE>(3, allpieces) && !isAttacked<WHITE>(4, allpieces) && !isAttacked<WHITE>(5, allpieces);
+    }
+    if (type & KING_SIDE_CASTLE_MOVE_MASK) {
+        return POW2_59 & chessboard[KING_BLACK] && chessboard[RIGHT_CASTLE_IDX] & RIGHT_KING_CASTLE_BLACK_MASK && !(allpieces & 0x600000000000000ULL) && chessboard[ROOK_BLACK] & POW2_56 && !isAttacked<BLACK>(57, allpieces) && !isAttacked<BLACK>(58, allpieces) && !isAttacked<BLACK>(59, allpieces);
+    }
+    return POW2_59 & chessboard[KING_BLACK] && chessboard[RIGHT_CASTLE_IDX] & RIGHT_QUEEN_CASTLE_BLACK_MASK && !(allpieces & 0x7000000000000000ULL) && chessboard[ROOK_BLACK] & POW2_63 && !isAttacked<BLACK>(59, allpieces) && !isAttacked<BLACK>(60, allpieces) && !isAttacked<BLACK>(61, allpieces);
+}
+
+// the king squares are kept in from and to, so castles can be packed like the other moves
+void GenMoves::tryAllCastle(const int side, const u64 allpieces) {
+    ASSERT_RANGE(side, 0, 1);
+    const int kingPos = side ? 3 : 59;
+    if (isCastleAllowed(side, KING_SIDE_CASTLE_MOVE_MASK, allpieces)) {
+        pushmove<KING_SIDE_CASTLE_MOVE_MASK>(kingPos, kingPos - 2, side, NO_PROMOTION, KING_BLACK + side);
+    }
+    if (isCastleAllowed(side, QUEEN_SIDE_CASTLE_MOVE_MASK, allpieces)) {
+        pushmove<QUEEN_SIDE_CASTLE_MOVE_MASK>(kingPos, kingPos + 2, side, NO_PROMOTION, KING_BLACK + side);
     }
 }
 
@@ -315,17 +390,21 @@ void GenMoves::unPerformCastle(const int side, const uchar type) {
             ASSERT(getPieceAt(side, POW2_2) == ROOK_WHITE);
             chessboard[KING_WHITE] = (chessboard[KING_WHITE] | POW2_3) & NOTPOW2_1;
             chessboard[ROOK_WHITE] = (chessboard[ROOK_WHITE] | POW2_0) & NOTPOW2_2;
+            moveMailbox(1, 3, 2, 0);
         } else {
             chessboard[KING_WHITE] = (chessboard[KING_WHITE] | POW2_3) & NOTPOW2_5;
             chessboard[ROOK_WHITE] = (chessboard[ROOK_WHITE] | POW2_7) & NOTPOW2_4;
+            moveMailbox(5, 3, 4, 7);
         }
     } else {
         if (type & KING_SIDE_CASTLE_MOVE_MASK) {
             chessboard[KING_BLACK] = (chessboard[KING_BLACK] | POW2_59) & NOTPOW2_57;
             chessboard[ROOK_BLACK] = (chessboard[ROOK_BLACK] | POW2_56) & NOTPOW2_58;
+            moveMailbox(57, 59, 58, 56);
         } else {
             chessboard[KING_BLACK] = (chessboard[KING_BLACK] | POW2_59) & NOTPOW2_61;
             chessboard[ROOK_BLACK] = (chessboard[ROOK_BLACK] | POW2_63) & NOTPOW2_60;
+            moveMailbox(61, 59, 60, 63);
         }
     }
 }
@@ -335,6 +414,9 @@ void GenMoves::takeback(_Tmove *move, const u64 oldkey, bool rep) {
         popStackMove();
     }
     chessboard[ZOBRISTKEY_IDX] = oldkey;
+    movePawnKey(move);
+    moveOccupancy(move);
+    chessboard[MATERIALKEY_IDX] -= getMaterialDelta(move);
     chessboard[ENPASSANT_IDX] = NO_ENPASSANT;
     int pieceFrom, posTo, posFrom, movecapture;
     chessboard[RIGHT_CASTLE_IDX] = move->type & 0xf0;
@@ -346,15 +428,20 @@ void GenMoves::takeback(_Tmove *move, const u64 oldkey, bool rep) {
         ASSERT_RANGE(posTo, 0, 63);
         pieceFrom = move->pieceFrom;
         chessboard[pieceFrom] = (chessboard[pieceFrom] & NOTPOW2[posTo]) | POW2[posFrom];
+        mailbox[posFrom] = (uchar) pieceFrom;
+        mailbox[posTo] = (uchar) movecapture;
         if (movecapture != SQUARE_FREE) {
             if (((move->type & 0x3) != ENPASSANT_MOVE_MASK)) {
                 chessboard[movecapture] |= POW2[posTo];
             } else {
                 ASSERT(movecapture == (move->side ^ 1));
+                mailbox[posTo] = SQUARE_FREE;
                 if (move->side) {
                     chessboard[movecapture] |= POW2[posTo - 8];
+                    mailbox[posTo - 8] = (uchar) movecapture;
                 } else {
                     chessboard[movecapture] |= POW2[posTo + 8];
+                    mailbox[posTo + 8] = (uchar) movecapture;
                 }
             }
         }
@@ -365,20 +452,26 @@ void GenMoves::takeback(_Tmove *move, const u64 oldkey, bool rep) {
         ASSERT(posTo >= 0 && move->side >= 0 && move->promotionPiece >= 0);
         chessboard[(uchar) move->side] |= POW2[posFrom];
         chessboard[(uchar) move->promotionPiece] &= NOTPOW2[posTo];
+        mailbox[posFrom] = (uchar) move->side;
+        mailbox[posTo] = (uchar) movecapture;
         if (movecapture != SQUARE_FREE) {
             chessboard[movecapture] |= POW2[posTo];
         }
     } else if (move->type & 0xc) { //castle
         unPerformCastle(move->side, move->type);
     }
+    ASSERT(checkBoardState());
 }
 
 
-bool GenMoves::makemove(_Tmove *move, bool rep, bool checkInCheck) {
+bool GenMoves::makemove(_Tmove *move, bool rep) {
     ASSERT(move);
     ASSERT(bitCount(chessboard[KING_WHITE]) == 1 && bitCount(chessboard[KING_BLACK]) == 1);
     int pieceFrom = SQUARE_FREE, posTo, posFrom, movecapture = SQUARE_FREE;
     uchar rightCastleOld = chessboard[RIGHT_CASTLE_IDX];
+    movePawnKey(move);
+    moveOccupancy(move);
+    chessboard[MATERIALKEY_IDX] += getMaterialDelta(move);
     if (!(move->type & 0xc)) { //no castle
         posTo = move->to;
         posFrom = move->from;
@@ -392,11 +485,14 @@ bool GenMoves::makemove(_Tmove *move, bool rep, bool checkInCheck) {
             ASSERT(move->promotionPiece >= 0);
             chessboard[(uchar) move->promotionPiece] |= POW2[posTo];
             updateZobristKey((uchar) move->promotionPiece, posTo);
+            mailbox[posTo] = (uchar) move->promotionPiece;
         } else {
             chessboard[pieceFrom] = (chessboard[pieceFrom] | POW2[posTo]) & NOTPOW2[posFrom];
             updateZobristKey(pieceFrom, posFrom);
             updateZobristKey(pieceFrom, posTo);
+            mailbox[posTo] = (uchar) pieceFrom;
         }
+        mailbox[posFrom] = SQUARE_FREE;
         if (movecapture != SQUARE_FREE) {
             if ((move->type & 0x3) != ENPASSANT_MOVE_MASK) {
                 chessboard[movecapture] &= NOTPOW2[posTo];
@@ -406,9 +502,11 @@ bool GenMoves::makemove(_Tmove *move, bool rep, bool checkInCheck) {
                 if (move->side) {
                     chessboard[movecapture] &= NOTPOW2[posTo - 8];
                     updateZobristKey(movecapture, posTo - 8);
+                    mailbox[posTo - 8] = SQUARE_FREE;
                 } else {
                     chessboard[movecapture] &= NOTPOW2[posTo + 8];
                     updateZobristKey(movecapture, posTo + 8);
+                    mailbox[posTo + 8] = SQUARE_FREE;
                 }
             }
         }
@@ -471,7 +569,8 @@ bool GenMoves::makemove(_Tmove *move, bool rep, bool checkInCheck) {
         }
         pushStackMove(chessboard[ZOBRISTKEY_IDX]);
     }
-    if ((forceCheck || (checkInCheck && !perftMode)) && ((move->side == WHITE && inCheck<WHITE>()) || (move->side == BLACK && inCheck<BLACK>()))) {
+    ASSERT(checkBoardState());
+    if (forceCheck && ((move->side == WHITE && inCheck<WHITE>()) || (move->side == BLACK && inCheck<BLACK>()))) {
         return false;
     }
     return true;
@@ -606,6 +705,8 @@ void GenMoves::writeRandomFen(const vector<int> pieces) {
             chessboard[pieces[i]] |= POW2[rand() % 64];
             check |= chessboard[pieces[i]];
         }
+        initOccupancy();
+        initMailbox();
 
         if (bitCount(check) == (2 + (int) pieces.size()) && !inCheck<WHITE>() && !inCheck<BLACK>()) {
             cout << boardToFen() << "\n";
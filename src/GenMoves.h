@@ -44,6 +44,8 @@ public:
         ASSERT_RANGE(side, 0, 1);
         ASSERT(chessboard[KING_BLACK]);
         ASSERT(chessboard[KING_WHITE]);
+        ASSERT(legalMask[listId].kingPos == BITScanForward(chessboard[KING_BLACK + side]));
+        ASSERT(legalMask[listId].allpieces == allpieces);
         tryAllCastle(side, allpieces);
         performDiagShift(BISHOP_BLACK + side, side, allpieces);
         performRankFileShift(ROOK_BLACK + side, side, allpieces);
@@ -54,12 +56,16 @@ public:
         performKingShiftCapture(side, ~allpieces);
     }
 
-    template<int side>
+    template<int side, bool setMask = true>
     bool generateCaptures(const u64 enemies, const u64 friends) {
         ASSERT_RANGE(side, 0, 1);
         ASSERT(chessboard[KING_BLACK]);
         ASSERT(chessboard[KING_WHITE]);
         u64 allpieces = enemies | friends;
+        if (setMask) {
+            setLegalMask<side>(friends, allpieces);
+        }
+        ASSERT(legalMask[listId].allpieces == allpieces);
         if (performPawnCapture<side>(enemies)) {
             return true;
         }
@@ -84,6 +90,22 @@ public:
         return false;
     }
 
+    // size of the legal move list, without making the moves; underpromotions are counted only in perft mode
+    template<int side>
+    int countLegalMoves() {
+        incListId();
+        const u64 friends = getBitmap<side>();
+        const u64 enemies = getBitmap<side ^ 1>();
+        bool b = generateCaptures<side>(enemies, friends);
+        ASSERT(!b);
+        generateMoves<side>(friends | enemies);
+        const int n = getListSize();
+        decListId();
+        return n;
+    }
+
+    int countLegalMoves();
+
     bool getForceCheck() {
         return forceCheck;
     }
@@ -253,7 +275,7 @@ public:
 
     void performRankFileShift(const int piece, const int side, const u64 allpieces);
 
-    bool makemove(_Tmove *move, bool rep = true, bool = false);
+    bool makemove(_Tmove *move, bool rep = true);
 
     void incListId() {
         listId++;
@@ -300,13 +322,108 @@ public:
     unsigned nCutAB, nNullMoveCut, nCutFp, nCutRazor;
     double betaEfficiency;
 #endif
+
+    static _TpackedMove packMove(const _Tmove *move) {
+        int kind, promotion = 0;
+        if (move->type & 0xc) {
+            kind = PACKED_CASTLE;
+        } else if ((move->type & 0x3) == ENPASSANT_MOVE_MASK) {
+            kind = PACKED_ENPASSANT;
+        } else if ((move->type & 0x3) == PROMOTION_MOVE_MASK) {
+            kind = PACKED_PROMOTION;
+            while (PACKED_PROMOTION_PIECE[promotion] != (move->promotionPiece & ~1)) {
+                promotion++;
+            }
+        } else {
+            kind = PACKED_STANDARD;
+        }
+        ASSERT_RANGE(move->from, 0, 63);
+        ASSERT_RANGE(move->to, 0, 63);
+        return (_TpackedMove) (move->from | (move->to << 6) | (promotion << 12) | (kind << 14));
+    }
+
+    static string packedMoveToString(const _TpackedMove packed);
+
+    // for the side to move, outside the search
+    bool unpackMove(const _TpackedMove packed, _Tmove *move);
+
+    bool isPseudoLegal(const _TpackedMove packed, _Tmove *move);
+
+    bool isLegal(const _Tmove *move);
+
+    // a capture of a cheaper piece that loses material in the exchange, it is tried after the quiet moves
+    template<int side>
+    bool isBadCapture(const _Tmove *move) const {
+        return PIECES_VALUE[move->capturedPiece] < PIECES_VALUE[move->pieceFrom] && see<side>(move) < 0;
+    }
+
+    // static exchange evaluation: material balance of the capture sequence on move->to,
+    // each side recaptures with its least valuable piece and the sliders behind it join through x-rays
+    template<int side>
+    int see(const _Tmove *move) const {
+        ASSERT_RANGE(move->from, 0, 63);
+        ASSERT_RANGE(move->to, 0, 63);
+        const int to = move->to;
+        int gain[32];
+        int d = 0;
+        int attackerValue;
+        u64 allpieces = getAllPieces() ^ POW2[move->from];
+        if ((move->type & 0x3) == ENPASSANT_MOVE_MASK) {
+            allpieces ^= POW2[side ? to - 8 : to + 8];
+            gain[0] = VALUEPAWN;
+            attackerValue = VALUEPAWN;
+        } else if ((move->type & 0x3) == PROMOTION_MOVE_MASK) {
+            gain[0] = PIECES_VALUE[move->capturedPiece] + PIECES_VALUE[move->promotionPiece] - VALUEPAWN;
+            attackerValue = PIECES_VALUE[move->promotionPiece];
+        } else {
+            gain[0] = PIECES_VALUE[move->capturedPiece];
+            attackerValue = PIECES_VALUE[move->pieceFrom];
+        }
+        const u64 queens = chessboard[QUEEN_BLACK] | chessboard[QUEEN_WHITE];
+        const u64 diagonal = chessboard[BISHOP_BLACK] | chessboard[BISHOP_WHITE] | queens;
+        const u64 rankFile = chessboard[ROOK_BLACK] | chessboard[ROOK_WHITE] | queens;
+        u64 attackers = (getAllAttackers<BLACK>(to, allpieces) | getAllAttackers<WHITE>(to, allpieces)) & allpieces;
+        int sideToCapture = side ^ 1;
+        while (true) {
+            const u64 sideAttackers = attackers & chessboard[OCCUPANCY_IDX + sideToCapture];
+            if (!sideAttackers) {
+                break;
+            }
+            int piece = 0;
+            u64 from;
+            while (!(from = sideAttackers & chessboard[SEE_ORDER[piece] + sideToCapture])) {
+                piece++;
+            }
+            ASSERT(d < 31);
+            d++;
+            gain[d] = attackerValue - gain[d - 1];
+            if (max(-gain[d - 1], gain[d]) < 0) {
+                break;
+            }
+            attackerValue = PIECES_VALUE[SEE_ORDER[piece]];
+            allpieces ^= from & -from;
+            if (SEE_ORDER[piece] != KNIGHT_BLACK && SEE_ORDER[piece] != KING_BLACK) {
+                attackers |= (Bitboard::getDiagonalAntiDiagonal(to, allpieces) & diagonal) | (Bitboard::getRankFile(to, allpieces) & rankFile);
+            }
+            attackers &= allpieces;
+            sideToCapture ^= 1;
+        }
+        while (d) {
+            gain[d - 1] = -max(-gain[d - 1], gain[d]);
+            d--;
+        }
+        return gain[0];
+    }
+
 protected:
     bool perftMode;
     int listId;
     _TmoveP *gen_list;
     static const u64 RANK_1 = 0xff00ULL;
+    static const u64 RANK_2 = 0xff0000ULL;
     static const u64 RANK_3 = 0xff000000ULL;
     static const u64 RANK_4 = 0xff00000000ULL;
+    static const u64 RANK_5 = 0xff0000000000ULL;
     static const u64 RANK_6 = 0xff000000000000ULL;
     static const uchar STANDARD_MOVE_MASK = 0x3;
     static const uchar ENPASSANT_MOVE_MASK = 0x1;
@@ -315,13 +432,276 @@ protected:
     static const int NO_PROMOTION = -1;
     int repetitionMapCount;
 
+    // the per ply state of the thread in a single allocation
+    typedef struct {
+        _TmoveP genList[MAX_PLY];
+        _Tmove moveList[MAX_PLY][MAX_MOVE];
+        int score[MAX_PLY][MAX_MOVE];
+        _TpvLine pvStack[MAX_PLY + 2];
+        u64 repetitionMap[MAX_REP_COUNT];
+    } _Tarena;
+
+    _Tarena *arena;
     u64 *repetitionMap;
+    _TpvLine *pvStack;
     int currentPly;
 
     u64 numMoves = 0;
     u64 numMovesq = 0;
 
-    _Tmove *getNextMove(decltype(gen_list));
+    // a slice of a move list being picked, the moves before cursor are already picked
+    typedef struct {
+        int cursor;
+        int end;
+        int nPicked;
+    } _TpickRange;
+
+    // the first picks usually cut, the moves left are sorted once instead of being scanned at each pick
+    static const int PICKS_BEFORE_SORT = 3;
+
+    _Tmove *getNextMove(decltype(gen_list), _TpickRange &range, const bool goodCaptures);
+
+    // stages of the move picker, each list is generated only when its stage is reached
+    static const uchar PICK_HASH = 0;
+    static const uchar PICK_GOOD_CAPTURES = 1;
+    static const uchar PICK_KILLERS = 2;
+    static const uchar PICK_QUIETS = 3;
+    static const uchar PICK_BAD_CAPTURES = 4;
+    static const uchar PICK_END = 5;
+    static const int BAD_CAPTURE_SCORE = 0x40000000;
+    static constexpr int SEE_ORDER[6] = {PAWN_BLACK, KNIGHT_BLACK, BISHOP_BLACK, ROOK_BLACK, QUEEN_BLACK, KING_BLACK};
+
+    typedef struct {
+        uchar stage;
+        int firstQuiet;
+        _TpickRange captures;
+        _TpickRange quiets;
+        int enpassant;
+        int killerId;
+        int nPicked;
+        _Tmove picked[3];    // hash move and killers, tried before the generation of their list
+    } _TmovePicker;
+
+    // two quiet moves per ply that caused a beta cutoff
+    _TpackedMove killers[MAX_PLY][2];
+
+    void setKiller(const _Tmove *move) {
+        ASSERT_RANGE(listId, 0, MAX_PLY - 1);
+        const _TpackedMove k = packMove(move);
+        if (killers[listId][0] != k) {
+            killers[listId][1] = killers[listId][0];
+            killers[listId][0] = k;
+        }
+    }
+
+    // the caller must read the key for takeback after this, the en passant square is taken off the board until the captures are generated
+    template<int side>
+    void initMovePicker(_TmovePicker &picker, const _TpackedMove hashMove, const u64 checkers) {
+        ASSERT_RANGE(listId, 0, MAX_PLY - 1);
+        resetList();
+        const u64 friends = getBitmap<side>();
+        setLegalMask<side>(friends, getAllPieces(), checkers);
+        picker.stage = PICK_GOOD_CAPTURES;
+        picker.firstQuiet = -1;
+        picker.enpassant = NO_ENPASSANT;
+        picker.killerId = 0;
+        picker.nPicked = 0;
+        if (hashMove != NO_PACKED_MOVE && unpackMove<side>(hashMove, &picker.picked[0])) {
+            picker.nPicked = 1;
+            picker.stage = PICK_HASH;
+            if (chessboard[ENPASSANT_IDX] != NO_ENPASSANT) {
+                picker.enpassant = chessboard[ENPASSANT_IDX];
+                updateZobristKey(13, chessboard[ENPASSANT_IDX]);
+                chessboard[ENPASSANT_IDX] = NO_ENPASSANT;
+            }
+        }
+    }
+
+    // builds the packed move of side if it is legal in the current position, the generation is not needed
+    template<int side>
+    bool unpackMove(const _TpackedMove packed, _Tmove *move) {
+        return isPseudoLegal<side>(packed, move) && isLegal<side>(move);
+    }
+
+    // builds the packed move of side if its piece can reach the target square, castles are checked completely
+    template<int side>
+    bool isPseudoLegal(const _TpackedMove packed, _Tmove *move) {
+        const int from = packed & 0x3f;
+        const int to = (packed >> 6) & 0x3f;
+        const int kind = packed >> 14;
+        if (from == to) {
+            return false;
+        }
+        move->side = (char) side;
+        move->from = (uchar) from;
+        move->to = (uchar) to;
+        move->pieceFrom = (char) (KING_BLACK + side);
+        move->promotionPiece = NO_PROMOTION;
+        move->capturedPiece = SQUARE_FREE;
+        if (kind == PACKED_CASTLE) {
+            const uchar castle = to == from - 2 ? KING_SIDE_CASTLE_MOVE_MASK : QUEEN_SIDE_CASTLE_MOVE_MASK;
+            if (from != (side ? 3 : 59) || (to != from - 2 && to != from + 2) || !isCastleAllowed(side, castle, legalMask[listId].allpieces)) {
+                return false;
+            }
+            move->type = (uchar) chessboard[RIGHT_CASTLE_IDX] | castle;
+            return true;
+        }
+        if (kind == PACKED_ENPASSANT) {
+            const int ep = (int) chessboard[ENPASSANT_IDX];
+            if (ep == NO_ENPASSANT || to != (side ? ep + 8 : ep - 8) || !(ENPASSANT_MASK[side ^ 1][ep] & chessboard[side] & POW2[from])) {
+                return false;
+            }
+            move->type = (uchar) chessboard[RIGHT_CASTLE_IDX] | ENPASSANT_MOVE_MASK;
+            move->pieceFrom = (char) side;
+            move->capturedPiece = (uchar) (side ^ 1);
+            return true;
+        }
+        const u64 allpieces = legalMask[listId].allpieces;
+        const int pieceFrom = getPieceAt<side>(POW2[from]);
+        if (pieceFrom == SQUARE_FREE || (getBitmap<side>() & POW2[to])) {
+            return false;
+        }
+        const int pieceTo = getPieceAt<side ^ 1>(POW2[to]);
+        if (pieceTo == KING_BLACK + (side ^ 1)) {
+            return false;
+        }
+        u64 reach;
+        switch (pieceFrom) {
+            case PAWN_BLACK:
+            case PAWN_WHITE:
+                if (pieceTo != SQUARE_FREE) {
+                    reach = PAWN_FORK_MASK[side][from];
+                } else if (side) {
+                    reach = (POW2[from] << 8) & ~allpieces;
+                    reach |= ((reach & RANK_2) << 8) & ~allpieces;
+                } else {
+                    reach = (POW2[from] >> 8) & ~allpieces;
+                    reach |= ((reach & RANK_5) >> 8) & ~allpieces;
+                }
+                break;
+            case KNIGHT_BLACK:
+            case KNIGHT_WHITE:
+                reach = KNIGHT_MASK[from];
+                break;
+            case KING_BLACK:
+            case KING_WHITE:
+                reach = NEAR_MASK1[from];
+                break;
+            case BISHOP_BLACK:
+            case BISHOP_WHITE:
+                reach = Bitboard::getDiagonalAntiDiagonal(from, allpieces);
+                break;
+            case ROOK_BLACK:
+            case ROOK_WHITE:
+                reach = Bitboard::getRankFile(from, allpieces);
+                break;
+            default:
+                reach = Bitboard::getRankFile(from, allpieces) | Bitboard::getDiagonalAntiDiagonal(from, allpieces);
+        }
+        if (!(reach & POW2[to])) {
+            return false;
+        }
+        const bool promotion = (pieceFrom == side) && (to > 55 || to < 8);
+        if (promotion != (kind == PACKED_PROMOTION)) {
+            return false;
+        }
+        move->type = (uchar) chessboard[RIGHT_CASTLE_IDX] | (promotion ? PROMOTION_MOVE_MASK : STANDARD_MOVE_MASK);
+        move->capturedPiece = (uchar) pieceTo;
+        move->pieceFrom = (char) pieceFrom;
+        move->promotionPiece = (char) (promotion ? PACKED_PROMOTION_PIECE[(packed >> 12) & 0x3] + side : NO_PROMOTION);
+        return true;
+    }
+
+    // a pseudo legal move of side that does not leave its king in check
+    template<int side>
+    bool isLegal(const _Tmove *move) {
+        switch (move->type & 0x3) {
+            case STANDARD_MOVE_MASK:
+                return isLegal<STANDARD_MOVE_MASK>(move->from, move->to, side, move->pieceFrom, move->capturedPiece, move->promotionPiece);
+            case PROMOTION_MOVE_MASK:
+                return isLegal<PROMOTION_MOVE_MASK>(move->from, move->to, side, move->pieceFrom, move->capturedPiece, move->promotionPiece);
+            case ENPASSANT_MOVE_MASK:
+                return isLegal<ENPASSANT_MOVE_MASK>(move->from, move->to, side, side, side ^ 1, NO_PROMOTION);
+            default:
+                return true;    //castle
+        }
+    }
+
+    bool isPicked(const _TmovePicker &picker, const _Tmove *move) const {
+        const _TpackedMove packed = packMove(move);
+        for (int i = 0; i < picker.nPicked; i++) {
+            if (packed == packMove(&picker.picked[i])) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template<int side>
+    _Tmove *getNextMove(_TmovePicker &picker) {
+        _Tmove *move;
+        switch (picker.stage) {
+            case PICK_HASH:
+                picker.stage = PICK_GOOD_CAPTURES;
+                return &picker.picked[0];
+            case PICK_GOOD_CAPTURES:
+                if (picker.firstQuiet == -1) {
+                    if (picker.enpassant != NO_ENPASSANT) {
+                        chessboard[ENPASSANT_IDX] = picker.enpassant;
+                        updateZobristKey(13, chessboard[ENPASSANT_IDX]);
+                    }
+                    const u64 friends = getBitmap<side>();
+                    bool b = generateCaptures<side, false>(getBitmap<side ^ 1>(), friends);
+                    ASSERT(!b);
+                    picker.firstQuiet = getListSize();
+                    for (int i = 0; i < picker.firstQuiet; i++) {
+                        if (isBadCapture<side>(getMove(i))) {
+                            gen_list[listId].score[i] -= BAD_CAPTURE_SCORE;
+                        }
+                    }
+                    picker.captures = {0, picker.firstQuiet, 0};
+                }
+                while ((move = getNextMove(&gen_list[listId], picker.captures, true))) {
+                    if (!isPicked(picker, move)) {
+                        return move;
+                    }
+                }
+                picker.stage = PICK_KILLERS;
+                // fall through
+            case PICK_KILLERS:
+                while (picker.killerId < 2) {
+                    const _TpackedMove k = killers[listId][picker.killerId++];
+                    _Tmove *killer = &picker.picked[picker.nPicked];
+                    if (k != NO_PACKED_MOVE && unpackMove<side>(k, killer) && !isPicked(picker, killer) &&
+                        killer->capturedPiece == SQUARE_FREE && killer->promotionPiece == NO_PROMOTION) {
+                        picker.nPicked++;
+                        return killer;
+                    }
+                }
+                picker.stage = PICK_QUIETS;
+                generateMoves<side>(legalMask[listId].allpieces);
+                picker.quiets = {picker.firstQuiet, getListSize(), 0};
+                // fall through
+            case PICK_QUIETS:
+                while ((move = getNextMove(&gen_list[listId], picker.quiets, false))) {
+                    if (!isPicked(picker, move)) {
+                        return move;
+                    }
+                }
+                picker.stage = PICK_BAD_CAPTURES;
+                // fall through
+            case PICK_BAD_CAPTURES:
+                while ((move = getNextMove(&gen_list[listId], picker.captures, false))) {
+                    if (!isPicked(picker, move)) {
+                        return move;
+                    }
+                }
+                picker.stage = PICK_END;
+                // fall through
+            default:
+                return nullptr;
+        }
+    }
 
     template<int side>
     bool isAttacked(const int position, const u64 allpieces) const {
@@ -358,7 +738,6 @@ protected:
         ASSERT_RANGE(side, 0, 1);
         ASSERT_RANGE(pieceFrom, 0, 12);
         ASSERT_RANGE(pieceTo, 0, 12);
-        ASSERT(perftMode || forceCheck);
         ASSERT(!(type & 0xc));
         bool result = 0;
         switch (type & 0x3) {
@@ -377,7 +756,7 @@ protected:
                 ASSERT(chessboard[KING_BLACK]);
                 ASSERT(chessboard[KING_WHITE]);
 
-                result = isAttacked<side>(BITScanForward(chessboard[KING_BLACK + side]), getBitmap<BLACK>() | getBitmap<WHITE>());
+                result = isAttacked<side>(BITScanForward(chessboard[KING_BLACK + side]), (getAllPieces() & NOTPOW2[from]) | POW2[to]);
                 chessboard[pieceFrom] = from1;
                 if (pieceTo != SQUARE_FREE) {
                     chessboard[pieceTo] = to1;
@@ -396,7 +775,7 @@ protected:
                     chessboard[pieceTo] &= NOTPOW2[to];
                 }
                 chessboard[promotionPiece] = chessboard[promotionPiece] | POW2[to];
-                result = isAttacked<side>(BITScanForward(chessboard[KING_BLACK + side]), getBitmap<BLACK>() | getBitmap<WHITE>());
+                result = isAttacked<side>(BITScanForward(chessboard[KING_BLACK + side]), (getAllPieces() & NOTPOW2[from]) | POW2[to]);
                 if (pieceTo != SQUARE_FREE) {
                     chessboard[pieceTo] = to1;
                 }
@@ -414,7 +793,7 @@ protected:
                 } else {
                     chessboard[side ^ 1] &= NOTPOW2[to + 8];
                 }
-                result = isAttacked<side>(BITScanForward(chessboard[KING_BLACK + side]), getBitmap<BLACK>() | getBitmap<WHITE>());
+                result = isAttacked<side>(BITScanForward(chessboard[KING_BLACK + side]), (getAllPieces() & NOTPOW2[from] & NOTPOW2[side ? to - 8 : to + 8]) | POW2[to]);
                 chessboard[side ^ 1] = to1;
                 chessboard[side] = from1;;
                 break;
@@ -429,12 +808,76 @@ protected:
         return result;
     }
 
+    // checkers and pinned pieces of the side to move, computed once per ply by generateCaptures
+    typedef struct {
+        u64 allpieces;
+        u64 checkers;
+        u64 pinned;
+        u64 checkMask;
+        int kingPos;
+    } _TlegalMask;
+
+    _TlegalMask legalMask[MAX_PLY];
+
+    template<int side>
+    void setLegalMask(const u64 friends, const u64 allpieces) {
+        setLegalMask<side>(friends, allpieces, getAllAttackers<side>(BITScanForward(chessboard[KING_BLACK + side]), allpieces));
+    }
+
+    // the checkers are already known by the caller
+    template<int side>
+    void setLegalMask(const u64 friends, const u64 allpieces, const u64 checkers) {
+        _TlegalMask &mask = legalMask[listId];
+        const int kingPos = BITScanForward(chessboard[KING_BLACK + side]);
+        ASSERT(kingPos != -1);
+        ASSERT(checkers == getAllAttackers<side>(kingPos, allpieces));
+        mask.allpieces = allpieces;
+        mask.kingPos = kingPos;
+        mask.checkers = checkers;
+        mask.pinned = 0;
+        const u64 enemies = allpieces & ~friends;
+        u64 snipers = (Bitboard::getRankFile(kingPos, enemies) & (chessboard[ROOK_BLACK + (side ^ 1)] | chessboard[QUEEN_BLACK + (side ^ 1)])) |
+                      (Bitboard::getDiagonalAntiDiagonal(kingPos, enemies) & (chessboard[BISHOP_BLACK + (side ^ 1)] | chessboard[QUEEN_BLACK + (side ^ 1)]));
+        while (snipers) {
+            const u64 between = Bitboard::getBetween(kingPos, BITScanForward(snipers)) & allpieces;
+            if (between && !(between & (between - 1))) {
+                mask.pinned |= between;
+            }
+            RESET_LSB(snipers);
+        }
+        if (!mask.checkers) {
+            mask.checkMask = 0xffffffffffffffffULL;
+        } else if (mask.checkers & (mask.checkers - 1)) {
+            mask.checkMask = 0;    // double check, only the king can move
+        } else {
+            mask.checkMask = mask.checkers | Bitboard::getBetween(kingPos, BITScanForward(mask.checkers));
+        }
+    }
+
+    template<uchar type>
+    bool isLegal(const int from, const int to, const int side, const int pieceFrom, const int pieceTo, const int promotionPiece) {
+        const _TlegalMask &mask = legalMask[listId];
+        bool result;
+        if (pieceFrom == KING_BLACK + side) {
+            const u64 allpieces = mask.allpieces & NOTPOW2[from];
+            result = side ? !isAttacked<WHITE>(to, allpieces) : !isAttacked<BLACK>(to, allpieces);
+        } else if ((type & 0x3) == ENPASSANT_MOVE_MASK) {
+            result = side ? !inCheck<WHITE, type>(from, to, pieceFrom, pieceTo, promotionPiece) : !inCheck<BLACK, type>(from, to, pieceFrom, pieceTo, promotionPiece);
+        } else {
+            result = (mask.checkMask & POW2[to]) && (!(mask.pinned & POW2[from]) || (Bitboard::getLine(mask.kingPos, from) & POW2[to]));
+        }
+        ASSERT(result == (side ? !inCheck<WHITE, type>(from, to, pieceFrom, pieceTo, promotionPiece) : !inCheck<BLACK, type>(from, to, pieceFrom, pieceTo, promotionPiece)));
+        return result;
+    }
+
     void performCastle(const int side, const uchar type);
 
     void unPerformCastle(const int side, const uchar type);
 
     void tryAllCastle(const int side, const u64 allpieces);
 
+    bool isCastleAllowed(const int side, const uchar type, const u64 allpieces);
+
 
     template<uchar type>
     bool pushmove(const int from, const int to, const int side, int promotionPiece, int pieceFrom) {
@@ -443,52 +886,48 @@ protected:
         int piece_captured = SQUARE_FREE;
         bool res = false;
         if (((type & 0x3) != ENPASSANT_MOVE_MASK) && !(type & 0xc)) {
-            piece_captured = side ? getPieceAt<BLACK>(POW2[to]) : getPieceAt<WHITE>(POW2[to]);
+            piece_captured = getPieceOn(to);
+            ASSERT(piece_captured == SQUARE_FREE || (piece_captured & 1) != side);
             if (piece_captured == KING_BLACK + (side ^ 1)) {
                 res = true;
             }
         } else if (!(type & 0xc)) {//no castle
             piece_captured = side ^ 1;
         }
-        if (!(type & 0xc) && (forceCheck || perftMode)) {//no castle
-            if (side == WHITE && inCheck<WHITE, type>(from, to, pieceFrom, piece_captured, promotionPiece)) {
-                return false;
-            }
-            if (side == BLACK && inCheck<BLACK, type>(from, to, pieceFrom, piece_captured, promotionPiece)) {
-                return false;
-            }
+        if (!(type & 0xc) && !isLegal<type>(from, to, side, pieceFrom, piece_captured, promotionPiece)) {//no castle
+            return false;
         }
         _Tmove *mos;
         ASSERT_RANGE(listId, 0, MAX_PLY - 1);
 
         ASSERT(getListSize() < MAX_MOVE);
         mos = &gen_list[listId].moveList[getListSize()];
+        int *score = &gen_list[listId].score[getListSize()];
         ++gen_list[listId].size;
         mos->type = (uchar) chessboard[RIGHT_CASTLE_IDX] | type;
         mos->side = (char) side;
         mos->capturedPiece = piece_captured;
+        mos->from = (uchar) from;
+        mos->to = (uchar) to;
+        mos->pieceFrom = pieceFrom;
+        mos->promotionPiece = (char) promotionPiece;
         if (type & 0x3) {
-            mos->from = (uchar) from;
-            mos->to = (uchar) to;
-            mos->pieceFrom = pieceFrom;
-            mos->promotionPiece = (char) promotionPiece;
             if (!perftMode) {
                 if (res == true) {
-                    mos->score = _INFINITE;
+                    *score = _INFINITE;
                 } else {
                     ASSERT_RANGE(pieceFrom, 0, 11);
                     ASSERT_RANGE(to, 0, 63);
                     ASSERT_RANGE(from, 0, 63);
-                    mos->score = killerHeuristic[from][to];
-                    mos->score += (PIECES_VALUE[piece_captured] >= PIECES_VALUE[pieceFrom]) ? (PIECES_VALUE[piece_captured] - PIECES_VALUE[pieceFrom]) * 2 : PIECES_VALUE[piece_captured];
-                    //mos->score += (MOV_ORD[pieceFrom][to] - MOV_ORD[pieceFrom][from]);
+                    *score = killerHeuristic[from][to];
+                    *score += (PIECES_VALUE[piece_captured] >= PIECES_VALUE[pieceFrom]) ? (PIECES_VALUE[piece_captured] - PIECES_VALUE[pieceFrom]) * 2 : PIECES_VALUE[piece_captured];
+                    //*score += (MOV_ORD[pieceFrom][to] - MOV_ORD[pieceFrom][from]);
                 }
             }
         } else if (type & 0xc) {    //castle
             ASSERT(chessboard[RIGHT_CASTLE_IDX]);
-            mos->score = 100;
+            *score = 100;
         }
-        mos->used = false;
         ASSERT(getListSize() < MAX_MOVE);
         return res;
     }
@@ -507,7 +946,7 @@ protected:
 
     template<int side>
     bool inCheck() const {
-        return isAttacked<side>(BITScanForward(chessboard[KING_BLACK + side]), getBitmap<BLACK>() | getBitmap<WHITE>());
+        return isAttacked<side>(BITScanForward(chessboard[KING_BLACK + side]), getAllPieces());
     }
 
     void setKillerHeuristic(const int from, const int to, const int value) {
@@ -545,6 +984,66 @@ private:
 
     int performRankFileCaptureAndShiftCount(const int position, const u64 enemies, const u64 allpieces);
 
+    // pawns moved or captured by move, the same xor does and undoes it
+    void movePawnKey(const _Tmove *move) {
+        if (move->type & 0xc) {
+            return;
+        }
+        if (move->pieceFrom == PAWN_BLACK || move->pieceFrom == PAWN_WHITE) {
+            updatePawnKey(move->pieceFrom, move->from);
+            if ((move->type & 0x3) != PROMOTION_MOVE_MASK) {
+                updatePawnKey(move->pieceFrom, move->to);
+            }
+        }
+        if (move->capturedPiece == PAWN_BLACK || move->capturedPiece == PAWN_WHITE) {
+            if ((move->type & 0x3) != ENPASSANT_MOVE_MASK) {
+                updatePawnKey(move->capturedPiece, move->to);
+            } else {
+                updatePawnKey(move->capturedPiece, move->side ? move->to - 8 : move->to + 8);
+            }
+        }
+    }
+
+    // castle: moves king and rook in the mailbox
+    void moveMailbox(const int kingFrom, const int kingTo, const int rookFrom, const int rookTo) {
+        mailbox[kingTo] = mailbox[kingFrom];
+        mailbox[rookTo] = mailbox[rookFrom];
+        mailbox[kingFrom] = mailbox[rookFrom] = SQUARE_FREE;
+    }
+
+    // the same xor makes and takes back the move
+    void moveOccupancy(const _Tmove *move) {
+        u64 friends, enemies = 0;
+        if (move->type & 0xc) {
+            friends = move->type & KING_SIDE_CASTLE_MOVE_MASK ? 0xfULL : 0xb8ULL;
+            if (move->side == BLACK) {
+                friends <<= 56;
+            }
+        } else {
+            friends = POW2[move->from] | POW2[move->to];
+            if ((move->type & 0x3) == ENPASSANT_MOVE_MASK) {
+                enemies = POW2[move->side ? move->to - 8 : move->to + 8];
+            } else if (move->capturedPiece != SQUARE_FREE) {
+                enemies = POW2[move->to];
+            }
+        }
+        chessboard[OCCUPANCY_IDX + move->side] ^= friends;
+        chessboard[OCCUPANCY_IDX + (move->side ^ 1)] ^= enemies;
+        chessboard[ALLPIECES_IDX] ^= friends ^ enemies;
+    }
+
+    // material key added by move, takeback subtracts it
+    u64 getMaterialDelta(const _Tmove *move) const {
+        if (move->type & 0xc) {
+            return 0;
+        }
+        u64 delta = -MATERIAL_WEIGHT[move->capturedPiece];
+        if ((move->type & 0x3) == PROMOTION_MOVE_MASK) {
+            delta += MATERIAL_WEIGHT[(uchar) move->promotionPiece] - MATERIAL_WEIGHT[(uchar) move->pieceFrom];
+        }
+        return delta;
+    }
+
     void popStackMove() {
         ASSERT(repetitionMapCount > 0);
         if (--repetitionMapCount && repetitionMap[repetitionMapCount - 1] == 0) {
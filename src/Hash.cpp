@@ -17,23 +17,43 @@
 */
 
 #include <mutex>
+#include <thread>
+#include <vector>
 #include "Hash.h"
 
-int Hash::HASH_SIZE = 0;
-Hash::_Thash *Hash::hashArray[2];
+#if defined(__linux__) && !defined(JS_MODE)
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define HASH_MMAP
+#endif
+
+u64 Hash::HASH_SIZE = 0;
+Hash::_Tbucket *Hash::hashArray = nullptr;
+void *Hash::hashArrayRaw = nullptr;
 mutex Hash::mutexConstructor;
 bool Hash::generated = false;
-Spinlock Hash::spinlockHashGreater;
-Spinlock Hash::spinlockHashAlways;
+bool Hash::largePages = true;
+uchar Hash::localGeneration = 0;
+uchar *Hash::generation = &Hash::localGeneration;
+string Hash::sharedName;
+int Hash::allocType = ALLOC_NONE;
+size_t Hash::allocSize = 0;
 
 Hash::Hash() {
     std::lock_guard<std::mutex> lock(mutexConstructor);
     if (generated) {
         return;
     }
+    static_assert(sizeof(_Thash) == 16, "_Thash size");
+    static_assert(sizeof(_Tbucket) == 64, "_Tbucket size");
 
     HASH_SIZE = 0;
-    hashArray[HASH_GREATER] = hashArray[HASH_ALWAYS] = nullptr;
+    hashArray = nullptr;
+    hashArrayRaw = nullptr;
 #ifdef DEBUG_MODE
     n_cut_hashA = n_cut_hashB = cutFailed = probeHash = 0;
     nRecordHashA = nRecordHashB = nRecordHashE = collisions = 0;
@@ -42,55 +62,400 @@ Hash::Hash() {
     generated = true;
 }
 
-void Hash::clearAge() {
-    for (int i = 0; i < HASH_SIZE; i++) {
-        hashArray[HASH_GREATER][i].entryAge = 0;
+// runs f(part, nPart) on all the hardware threads: parallel first-touch of the table
+template<class F>
+static void parallelRun(F f) {
+#ifdef JS_MODE
+    const int n = 1;
+#else
+    const int n = max(1, (int) thread::hardware_concurrency());
+#endif
+    if (n == 1) {
+        f(0, 1);
+        return;
+    }
+    vector<thread> v;
+    for (int i = 0; i < n; i++) {
+        v.push_back(thread(f, i, n));
+    }
+    for (thread &t:v) {
+        t.join();
     }
 }
 
 void Hash::clearHash() {
+    if (allocType == ALLOC_SHARED) {
+        // the other engines attached to the table are still using it
+        cout << "info string shared hash " << sharedName << " not cleared" << endl;
+        return;
+    }
+    parallelRun([this](const int part, const int nPart) { clearHash(part, nPart); });
+}
+
+void Hash::clearHash(const int part, const int nPart) {
     if (!HASH_SIZE) {
         return;
     }
-    memset(hashArray[HASH_ALWAYS], 0, sizeof(_Thash) * HASH_SIZE);
-    memset(hashArray[HASH_GREATER], 0, sizeof(_Thash) * HASH_SIZE);
+    const u64 first = HASH_SIZE * part / nPart;
+    const u64 last = HASH_SIZE * (part + 1) / nPart;
+    memset(hashArray + first, 0, sizeof(_Tbucket) * (last - first));
+}
+
+// moves the entries of a slice of the old table, concurrent stores can only lose entries
+void Hash::rehash(const _Tbucket *oldArray, const u64 oldSize, const int part, const int nPart) {
+    const u64 first = oldSize * part / nPart;
+    const u64 last = oldSize * (part + 1) / nPart;
+    for (u64 i = first; i < last; i++) {
+        for (int j = 0; j < BUCKET_SIZE; j++) {
+            const _Thash *old = &oldArray[i].entry[j];
+            if (!old->key) {
+                continue;
+            }
+            const u64 key = old->key ^old->data;
+            _Tbucket *bucket = &hashArray[getIndex(key)];
+            _Thash *replace = &bucket->entry[0];
+            if (j || replace->key) {
+                replace = &bucket->entry[1];
+                for (int k = 2; k < BUCKET_SIZE; k++) {
+                    if (isBetterVictim(&bucket->entry[k], replace)) {
+                        replace = &bucket->entry[k];
+                    }
+                }
+                if (replace->key && !isBetterVictim(replace, old)) {
+                    continue;
+                }
+            }
+            store(replace, key, old->data);
+        }
+    }
 }
 
 int Hash::getHashSize() {
-    return HASH_SIZE / (1024 * 1000 / (sizeof(_Thash) * 2));
+    return HASH_SIZE / (1024 * 1000 / sizeof(_Tbucket));
+}
+
+// per mille of the first 1000 entries written by the current search (UCI hashfull)
+int Hash::getHashFull() const {
+    int count = 0;
+    const int nBucket = min(HASH_SIZE, (u64) (1000 / BUCKET_SIZE));
+    for (int i = 0; i < nBucket; i++) {
+        for (int j = 0; j < BUCKET_SIZE; j++) {
+            const _Thash *hash = &hashArray[i].entry[j];
+            if (hash->key && hash->generation == *generation) {
+                count++;
+            }
+        }
+    }
+    return nBucket ? count * 1000 / (nBucket * BUCKET_SIZE) : 0;
+}
+
+// entries by depth (quiescence in row 0) and age (searches since stored, last column is >=)
+void Hash::getHashHistogram(u64 histogram[HISTOGRAM_DEPTH][HISTOGRAM_AGE]) const {
+    memset(histogram, 0, sizeof(u64) * HISTOGRAM_DEPTH * HISTOGRAM_AGE);
+    for (u64 i = 0; i < HASH_SIZE; i++) {
+        for (int j = 0; j < BUCKET_SIZE; j++) {
+            const _Thash *hash = &hashArray[i].entry[j];
+            if (hash->key) {
+                const int depth = max(0, min((int) hash->depth, HISTOGRAM_DEPTH - 1));
+                histogram[depth][min((int) getAge(hash), HISTOGRAM_AGE - 1)]++;
+            }
+        }
+    }
+}
+
+void Hash::setLargePages(const bool b) {
+    largePages = b;
+}
+
+bool Hash::getLargePages() const {
+    return largePages;
+}
+
+string Hash::getAllocInfo() {
+    static const string ALLOC_NAME[] = {"none", "calloc", "mmap", "hugetlb", "file", "shared"};
+    string s = "hash " + to_string(getHashSize()) + " MB, " + ALLOC_NAME[allocType];
+    if (allocType == ALLOC_SHARED) {
+        s += " " + sharedName;
+    }
+#ifdef HASH_MMAP
+    if (allocType == ALLOC_MMAP) {
+        s += " with transparent huge pages";
+    }
+#endif
+    return s;
+}
+
+Hash::_Tbucket *Hash::allocHash(const size_t size) {
+    size_t align = sizeof(_Tbucket);
+    hashArrayRaw = nullptr;
+#ifdef HASH_MMAP
+    static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    if (largePages) {
+        // explicit huge pages need reserved pages (vm.nr_hugepages), fallback to transparent huge pages
+        allocSize = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        void *mem = mmap(nullptr, allocSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (mem != MAP_FAILED) {
+            allocType = ALLOC_HUGETLB;
+            hashArrayRaw = mem;
+        } else {
+            allocSize = size + HUGE_PAGE_SIZE;
+            mem = mmap(nullptr, allocSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mem != MAP_FAILED) {
+                allocType = ALLOC_MMAP;
+                hashArrayRaw = mem;
+                align = HUGE_PAGE_SIZE;
+            }
+        }
+    }
+#endif
+    if (!hashArrayRaw) {
+        allocSize = size + align;
+        allocType = ALLOC_CALLOC;
+        hashArrayRaw = calloc(allocSize, 1);
+        if (!hashArrayRaw) {
+            return nullptr;
+        }
+    }
+    _Tbucket *aligned = (_Tbucket *) (((uintptr_t) hashArrayRaw + align - 1) & ~(uintptr_t) (align - 1));
+#if defined(HASH_MMAP) && defined(MADV_HUGEPAGE)
+    if (allocType == ALLOC_MMAP) {
+        madvise(aligned, size, MADV_HUGEPAGE);
+    }
+#endif
+    return aligned;
+}
+
+#ifdef HASH_MMAP
+
+// shm_open without librt: a POSIX shared memory object is a file in /dev/shm
+Hash::_Tbucket *Hash::allocSharedHash(u64 &nBucket) {
+    const string path = "/dev/shm/" + sharedName;
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    const bool creator = fd != -1;
+    if (!creator) {
+        fd = open(path.c_str(), O_RDWR);
+        if (fd == -1) {
+            return nullptr;
+        }
+    }
+    size_t size = sizeof(_ThashHeader) + sizeof(_Tbucket) * nBucket;
+    if (creator) {
+        if (ftruncate(fd, size)) {
+            close(fd);
+            unlink(path.c_str());
+            return nullptr;
+        }
+    } else {
+        // the creator may still be initializing the segment
+        struct stat st;
+        for (int i = 0; i < 100 && !fstat(fd, &st) && (size_t) st.st_size < sizeof(_ThashHeader); i++) {
+            usleep(10000);
+        }
+        if (fstat(fd, &st) || (size_t) st.st_size < sizeof(_ThashHeader)) {
+            close(fd);
+            return nullptr;
+        }
+        size = st.st_size;
+    }
+    void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        return nullptr;
+    }
+    _ThashHeader *header = (_ThashHeader *) mem;
+    if (creator) {
+        _ThashHeader tmp;
+        fillHeader(tmp, nBucket);
+        memcpy((char *) header + sizeof(header->magic), (char *) &tmp + sizeof(tmp.magic), sizeof(_ThashHeader) - sizeof(tmp.magic));
+        __sync_synchronize();
+        // the magic is written last, it marks the segment as ready
+        memcpy(header->magic, tmp.magic, sizeof(tmp.magic));
+    } else {
+        for (int i = 0; i < 100 && memcmp(header->magic, "CINHASH", 8); i++) {
+            usleep(10000);
+        }
+        if (!checkHeader(*header) || size < sizeof(_ThashHeader) + sizeof(_Tbucket) * header->nBucket) {
+            munmap(mem, size);
+            return nullptr;
+        }
+        nBucket = header->nBucket;
+    }
+    hashArrayRaw = mem;
+    allocSize = size;
+    allocType = ALLOC_SHARED;
+    generation = &header->generation;
+    return (_Tbucket *) ((char *) mem + sizeof(_ThashHeader));
+}
+
+#endif
+
+bool Hash::setSharedHash(const string &name) {
+#ifdef HASH_MMAP
+    const size_t first = name.find_first_not_of('/');
+    const string s = first == string::npos ? "" : name.substr(first);
+    if (s.find('/') != string::npos) {
+        return false;
+    }
+    sharedName = s;
+    return true;
+#else
+    return name.empty();
+#endif
 }
 
 void Hash::setHashSize(int mb) {
-    dispose();
+    _Tbucket *oldArray = hashArray;
+    void *oldRaw = hashArrayRaw;
+    const int oldType = allocType;
+    const size_t oldSize = allocSize;
+    const u64 oldHashSize = HASH_SIZE;
+    localGeneration = *generation;
+    generation = &localGeneration;
+    hashArray = nullptr;
+    hashArrayRaw = nullptr;
+    allocType = ALLOC_NONE;
+    HASH_SIZE = 0;
     if (mb) {
-        int tmp = mb * 1024 * 1000 / (sizeof(_Thash) * 2);
-        hashArray[HASH_GREATER] = (_Thash *) calloc(tmp, sizeof(_Thash));
-        if (!hashArray[HASH_GREATER]) {
-            fatal("info string error - no memory");
-            exit(1);
+        u64 tmp = (u64) mb * 1024 * 1000 / sizeof(_Tbucket);
+#ifdef HASH_MMAP
+        if (!sharedName.empty()) {
+            // attaching to an existing segment uses its size
+            hashArray = allocSharedHash(tmp);
+            if (!hashArray) {
+                cout << "info string error - shared hash " << sharedName << " not available, using a private table" << endl;
+            }
         }
-        hashArray[HASH_ALWAYS] = (_Thash *) calloc(tmp, sizeof(_Thash));
-        if (!hashArray[HASH_ALWAYS]) {
+        if (!hashArray)
+#endif
+            hashArray = allocHash(tmp * sizeof(_Tbucket));
+        if (!hashArray) {
             fatal("info string error - no memory");
             exit(1);
         }
         HASH_SIZE = tmp;
+        if (allocType != ALLOC_SHARED) {
+            // mmap memory is zero and not yet touched
+            clearHash();
+        }
+        if (oldArray) {
+            parallelRun([this, oldArray, oldHashSize](const int part, const int nPart) { rehash(oldArray, oldHashSize, part, nPart); });
+        }
     }
+    freeHash(oldRaw, oldType, oldSize);
 }
 
-void Hash::dispose() {
-    if (hashArray[HASH_GREATER]) {
-        free(hashArray[HASH_GREATER]);
+void Hash::freeHash(void *raw, const int type, const size_t size) {
+    if (!raw) {
+        return;
     }
-    if (hashArray[HASH_ALWAYS]) {
-        free(hashArray[HASH_ALWAYS]);
+#ifdef HASH_MMAP
+    if (type != ALLOC_CALLOC) {
+        munmap(raw, size);
+        return;
     }
-    hashArray[HASH_GREATER] = hashArray[HASH_ALWAYS] = nullptr;
+#endif
+    free(raw);
+}
+
+void Hash::dispose() {
+    localGeneration = *generation;
+    generation = &localGeneration;
+    freeHash(hashArrayRaw, allocType, allocSize);
+    hashArray = nullptr;
+    hashArrayRaw = nullptr;
+    allocType = ALLOC_NONE;
+    allocSize = 0;
     HASH_SIZE = 0;
     generated = false;
 }
 
-Hash::~Hash() {
+void Hash::fillHeader(_ThashHeader &header, const u64 nBucket) {
+    memset(&header, 0, sizeof(_ThashHeader));
+    strncpy(header.version, NAME.c_str(), sizeof(header.version) - 1);
+    header.entrySize = sizeof(_Thash);
+    header.bucketSize = BUCKET_SIZE;
+    header.nBucket = nBucket;
+    header.generation = *generation;
+    memcpy(header.magic, "CINHASH", 8);
+}
+
+bool Hash::checkHeader(const _ThashHeader &header) {
+    return !memcmp(header.magic, "CINHASH", 8) && !strncmp(header.version, NAME.c_str(), sizeof(header.version) - 1) &&
+           header.entrySize == sizeof(_Thash) && header.bucketSize == BUCKET_SIZE && header.nBucket;
+}
+
+bool Hash::saveHash(const string &file) {
+    if (!HASH_SIZE) {
+        return false;
+    }
+    _ThashHeader header;
+    fillHeader(header, HASH_SIZE);
+
+    const string tmpFile = file + ".tmp";
+    ofstream f;
+    f.open(tmpFile, ios_base::out | ios_base::binary);
+    if (!f.is_open()) {
+        return false;
+    }
+    f.write(reinterpret_cast<char *>(&header), sizeof(_ThashHeader));
+    f.write(reinterpret_cast<char *>(hashArray), sizeof(_Tbucket) * HASH_SIZE);
+    f.close();
+    if (f.fail()) {
+        return false;
+    }
+    return rename(tmpFile.c_str(), file.c_str()) == 0;
+}
+
+bool Hash::loadHash(const string &file) {
+    _ThashHeader header;
+    ifstream f;
+    f.open(file, ios_base::in | ios_base::binary);
+    if (!f.is_open()) {
+        return false;
+    }
+    f.read(reinterpret_cast<char *>(&header), sizeof(_ThashHeader));
+    if (!f || !checkHeader(header)) {
+        return false;
+    }
+    const size_t size = sizeof(_ThashHeader) + sizeof(_Tbucket) * header.nBucket;
+    f.seekg(0, ios_base::end);
+    if ((size_t) f.tellg() < size) {
+        return false;
+    }
     dispose();
+#ifdef HASH_MMAP
+    f.close();
+    // private mapping: pages are read on demand and never written back to the file
+    const int fd = open(file.c_str(), O_RDONLY);
+    if (fd != -1) {
+        void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mem != MAP_FAILED) {
+            hashArrayRaw = mem;
+            allocSize = size;
+            allocType = ALLOC_FILE;
+            hashArray = (_Tbucket *) ((char *) mem + sizeof(_ThashHeader));
+        }
+    }
+    if (!hashArray) {
+        f.open(file, ios_base::in | ios_base::binary);
+#endif
+        hashArray = allocHash(sizeof(_Tbucket) * header.nBucket);
+        if (!hashArray) {
+            fatal("info string error - no memory");
+            exit(1);
+        }
+        f.seekg(sizeof(_ThashHeader));
+        f.read(reinterpret_cast<char *>(hashArray), sizeof(_Tbucket) * header.nBucket);
+#ifdef HASH_MMAP
+    }
+#endif
+    HASH_SIZE = header.nBucket;
+    *generation = header.generation;
+    generated = true;
+    return true;
 }
 
+Hash::~Hash() {
+    dispose();
+}
@@ -24,7 +24,6 @@
 #include "namespaces/board.h"
 #include "util/Singleton.h"
 #include "util/logger.h"
-#include "threadPool/Spinlock.h"
 #include <mutex>
 
 using namespace _board;
@@ -38,20 +37,42 @@ public:
     static const int HASH_GREATER = 0;
     static const int HASH_ALWAYS = 1;
 
+    // key is stored xored with data, so a torn entry written by another thread fails the key check (lock-free)
     typedef struct {
         u64 key;
-        short score;
-        char depth;
-        uchar from:6;
-        uchar to:6;
-        uchar entryAge:1;
-        uchar flags:2;
+        union {
+            u64 data;
+            struct {
+                short score;
+                char depth;
+                uchar flags;
+                _TpackedMove move;
+                uchar generation;
+            };
+        };
     } _Thash;
 
+    // one cache line: slot 0 is always replaced (HASH_GREATER), the others are depth-preferred (HASH_ALWAYS)
+    static const int BUCKET_SIZE = 4;
+
+    typedef struct alignas(64) {
+        _Thash entry[BUCKET_SIZE];
+    } _Tbucket;
+
     enum : char {
         hashfALPHA = 0, hashfEXACT = 1, hashfBETA = 2
     };
 
+    // release counters, one set per search thread
+    typedef struct {
+        u64 probe, hit[2], cut, store, collision;
+    } _ThashStats;
+
+    static const int HISTOGRAM_DEPTH = 32;
+    static const int HISTOGRAM_AGE = 5;
+
+    _ThashStats hashStats = {};
+
 #ifdef DEBUG_MODE
     unsigned nRecordHashA, nRecordHashB, nRecordHashE, collisions;
 
@@ -66,27 +87,78 @@ public:
 
     void clearHash();
 
-    void clearAge();
+    void clearHash(const int part, const int nPart);
+
+    // a shared table counts the searches of all the engines attached to it
+    void newGeneration() {
+        if (allocType == ALLOC_SHARED) {
+            __sync_fetch_and_add(generation, 1);
+        } else {
+            (*generation)++;
+        }
+    }
+
+    int getHashFull() const;
+
+    void getHashHistogram(u64 histogram[HISTOGRAM_DEPTH][HISTOGRAM_AGE]) const;
+
+    void setLargePages(const bool b);
+
+    bool getLargePages() const;
+
+    string getAllocInfo();
+
+    bool saveHash(const string &file);
+
+    bool loadHash(const string &file);
+
+    bool setSharedHash(const string &name);
+
+    // multiply-shift: maps the key on [0, nBucket) without a division
+    static FORCEINLINE u64 getIndex(const u64 zobristKeyR, const u64 nBucket) {
+#ifdef __SIZEOF_INT128__
+        return (u64) (((unsigned __int128) zobristKeyR * nBucket) >> 64);
+#else
+        return ((zobristKeyR >> 32) * nBucket) >> 32;
+#endif
+    }
+
+    // to be called as soon as the key of the child position is known
+    FORCEINLINE void prefetchHash(const u64 zobristKeyR) const {
+        PREFETCH(&hashArray[getIndex(zobristKeyR)]);
+    }
 
     template<bool smp, int type>
     bool readHash(_Thash *phashe[2], const u64 zobristKeyR, _Thash *hashMini) {
-        bool b = false;
-        _Thash *hash = phashe[type] = &(hashArray[type][zobristKeyR % HASH_SIZE]);
-
-        if (smp && type == HASH_GREATER)spinlockHashGreater.lock();
-        if (smp && type == HASH_ALWAYS)spinlockHashAlways.lock();
-        if (hash->key == zobristKeyR) {
-            b = true;
-            memcpy(hashMini, hash, sizeof(_Thash));
+        _Tbucket *bucket = &hashArray[getIndex(zobristKeyR)];
+
+        if (type == HASH_GREATER) {
+            hashStats.probe++;
+            _Thash *hash = phashe[type] = &bucket->entry[0];
+            if (probe(hash, zobristKeyR, hashMini)) {
+                hashStats.hit[type]++;
+                return true;
+            }
+            return false;
         }
-        if (smp && type == HASH_GREATER)spinlockHashGreater.unlock();
-        if (smp && type == HASH_ALWAYS)spinlockHashAlways.unlock();
-
-        return b;
+        _Thash *replace = &bucket->entry[1];
+        for (int i = 1; i < BUCKET_SIZE; i++) {
+            _Thash *hash = &bucket->entry[i];
+            if (probe(hash, zobristKeyR, hashMini)) {
+                hashStats.hit[type]++;
+                phashe[type] = hash;
+                return true;
+            }
+            if (isBetterVictim(hash, replace)) {
+                replace = hash;
+            }
+        }
+        phashe[type] = replace;
+        return false;
     }
 
     template<bool smp>
-    void recordHash(bool running, _Thash *rootHash[2], const char depth, const char flags, const u64 key, const int score, _Tmove *bestMove) {
+    void recordHash(bool running, _Thash *rootHash[2], const char depth, const char flags, const u64 key, const int score, const _TpackedMove bestMove) {
         ASSERT(key);
         ASSERT(rootHash[HASH_GREATER]);
         ASSERT(rootHash[HASH_ALWAYS]);
@@ -96,21 +168,14 @@ public:
         ASSERT(abs(score) <= 32200);
         _Thash tmp;
 
-        tmp.key = key;
+        tmp.data = 0;
         tmp.score = score;
         tmp.flags = flags;
         tmp.depth = depth;
-        if (bestMove && bestMove->from != bestMove->to) {
-            tmp.from = bestMove->from;
-            tmp.to = bestMove->to;
-        } else {
-            tmp.from = tmp.to = 0;
-        }
-
-        if (smp)spinlockHashGreater.lock();
-        memcpy(rootHash[HASH_GREATER], &tmp, sizeof(_Thash));
-        if (smp)spinlockHashGreater.unlock();
-
+        tmp.generation = *generation;
+        tmp.move = bestMove;
+        hashStats.store++;
+        store(rootHash[HASH_GREATER], key, tmp.data);
 
 #ifdef DEBUG_MODE
         if (flags == hashfALPHA) {
@@ -121,33 +186,96 @@ public:
             nRecordHashE++;
         }
 #endif
-        tmp.entryAge = 1;
 
-        if (smp)spinlockHashAlways.lock();
-        if (rootHash[HASH_ALWAYS]->key && rootHash[HASH_ALWAYS]->depth >= depth && rootHash[HASH_ALWAYS]->entryAge) {
+        _Thash *hash = rootHash[HASH_ALWAYS];
+        if (hash->key && hash->depth >= depth && hash->generation == *generation) {
+            hashStats.collision++;
             INC(collisions);
-            if (smp)spinlockHashAlways.unlock();
             return;
         }
-        memcpy(rootHash[HASH_ALWAYS], &tmp, sizeof(_Thash));
-        if (smp)spinlockHashAlways.unlock();
-
+        store(hash, key, tmp.data);
     }
 
 private:
     static bool generated;
-    static int HASH_SIZE;
+    static u64 HASH_SIZE;
 #ifdef JS_MODE
     static const int HASH_SIZE_DEFAULT = 1;
 #else
     static const int HASH_SIZE_DEFAULT = 64;
 #endif
 
+    enum {
+        ALLOC_NONE, ALLOC_CALLOC, ALLOC_MMAP, ALLOC_HUGETLB, ALLOC_FILE, ALLOC_SHARED
+    };
+
+    // saveHash/loadHash file and shared memory header, buckets follow
+    typedef struct alignas(64) {
+        char magic[8];
+        char version[32];
+        unsigned entrySize;
+        unsigned bucketSize;
+        u64 nBucket;
+        uchar generation;
+    } _ThashHeader;
+
+    static bool largePages;
+    // points to localGeneration, or to the header of the shared table
+    static uchar *generation;
+    static uchar localGeneration;
+    static int allocType;
+    static size_t allocSize;
+
+    static string sharedName;
+
+    _Tbucket *allocHash(const size_t size);
+
+    _Tbucket *allocSharedHash(u64 &nBucket);
+
+    void fillHeader(_ThashHeader &header, const u64 nBucket);
+
+    bool checkHeader(const _ThashHeader &header);
+
     void dispose();
 
-    static _Thash *hashArray[2];
-    static Spinlock spinlockHashGreater;
-    static Spinlock spinlockHashAlways;
+    static void freeHash(void *raw, const int type, const size_t size);
+
+    void rehash(const _Tbucket *oldArray, const u64 oldSize, const int part, const int nPart);
+
+    static FORCEINLINE u64 getIndex(const u64 zobristKeyR) {
+        return getIndex(zobristKeyR, HASH_SIZE);
+    }
+
+    // number of searches since the entry was stored
+    static FORCEINLINE uchar getAge(const _Thash *hash) {
+        return *generation - hash->generation;
+    }
+
+    // depth-preferred replacement: empty, then older, then shallower
+    static FORCEINLINE bool isBetterVictim(const _Thash *hash, const _Thash *than) {
+        if (!hash->key || !than->key) {
+            return !hash->key && than->key;
+        }
+        return getAge(hash) > getAge(than) || (getAge(hash) == getAge(than) && hash->depth < than->depth);
+    }
+
+    static FORCEINLINE bool probe(const _Thash *hash, const u64 zobristKeyR, _Thash *hashMini) {
+        const u64 data = hash->data;
+        if ((hash->key ^ data) != zobristKeyR) {
+            return false;
+        }
+        hashMini->key = zobristKeyR;
+        hashMini->data = data;
+        return true;
+    }
+
+    static FORCEINLINE void store(_Thash *hash, const u64 key, const u64 data) {
+        hash->key = key ^ data;
+        hash->data = data;
+    }
+
+    static _Tbucket *hashArray;
+    static void *hashArrayRaw;
     static mutex mutexConstructor;
 
 };
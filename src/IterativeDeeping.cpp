@@ -81,12 +81,11 @@ void IterativeDeeping::run() {
     int mply = 0;
     if (openBook) {
         ASSERT(openBook);
-        string obMove = openBook->search(searchManager.boardToFen());
-        if (!obMove.empty()) {
-            _Tmove move;
-            searchManager.getMoveFromSan(obMove, &move);
+        const _TpackedMove obMove = openBook->search(searchManager.boardToFen());
+        _Tmove move;
+        if (obMove != NO_PACKED_MOVE && searchManager.unpackMove(obMove, &move)) {
             searchManager.makemove(&move);
-            cout << "bestmove " << obMove << endl;
+            cout << "bestmove " << Search::packedMoveToString(obMove) << endl;
             ADD(checkSmp2, -1);
             ASSERT(!checkSmp2);
             LOCK_RELEASE(running);
@@ -100,7 +99,7 @@ void IterativeDeeping::run() {
 
     searchManager.startClock();
     searchManager.clearKillerHeuristic();
-    searchManager.clearAge();
+    searchManager.newGeneration();
     searchManager.setForceCheck(false);
 
     auto start1 = std::chrono::high_resolution_clock::now();
@@ -120,7 +119,7 @@ void IterativeDeeping::run() {
 
         searchManager.setRunningThread(1);
         searchManager.setRunning(1);
-        if (!searchManager.getRes(resultMove, ponderMove, pvv, &mateIn)) {
+        if (!searchManager.getRes(resultMove, sc, ponderMove, pvv, &mateIn)) {
             debug("IterativeDeeping cmove == 0, exit");
             break;
         }
@@ -131,8 +130,7 @@ void IterativeDeeping::run() {
         timeTaken = Time::diffTime(end1, start1) + 1;
         totMoves += searchManager.getTotMoves();
 
-        sc = resultMove.score;
-        if (resultMove.score > _INFINITE - MAX_PLY) {
+        if (sc > _INFINITE - MAX_PLY) {
             sc = 0x7fffffff;
         }
 #ifdef DEBUG_MODE
@@ -193,20 +191,14 @@ void IterativeDeeping::run() {
         if (trace) {
 
             resultMove.capturedPiece = searchManager.getPieceAt(resultMove.side ^ 1, POW2[resultMove.to]);
-            bestmove = Search::decodeBoardinv(resultMove.type, resultMove.from, resultMove.side);
-            if (!(resultMove.type & (Search::KING_SIDE_CASTLE_MOVE_MASK | Search::QUEEN_SIDE_CASTLE_MOVE_MASK))) {
-                bestmove += Search::decodeBoardinv(resultMove.type, resultMove.to, resultMove.side);
-                if (resultMove.promotionPiece != -1) {
-                    bestmove += tolower(FEN_PIECE[(uchar) resultMove.promotionPiece]);
-                }
-            }
+            bestmove = Search::packedMoveToString(Search::packMove(&resultMove));
 
             if (abs(sc) > _INFINITE - MAX_PLY) {
                 cout << "info score mate 1 depth " << mply;
             } else {
                 cout << "info score cp " << sc << " depth " << mply - extension;
             }
-            cout << " nodes " << totMoves << " time " << timeTaken;
+            cout << " nodes " << totMoves << " time " << timeTaken << " hashfull " << searchManager.getHashFull();
             if (0)cout << " knps " << (totMoves / timeTaken);
             cout << " pv " << pvv << endl;
         }
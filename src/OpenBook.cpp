@@ -193,45 +193,27 @@ int OpenBook::findKey(u64 key, entry_t *entry) {
     }
 }
 
-void OpenBook::moveToString(char move_s[6], unsigned short move) {
-    const static char *promote_pieces = " nbrq";
-    int f, fr, ff, t, tr, tf, p;
-    f = (move >> 6) & 077;
-    fr = (f >> 3) & 0x7;
-    ff = f & 0x7;
-    t = move & 077;
-    tr = (t >> 3) & 0x7;
-    tf = t & 0x7;
-    p = (move >> 12) & 0x7;
-    move_s[0] = ff + 'a';
-    move_s[1] = fr + '1';
-    move_s[2] = tf + 'a';
-    move_s[3] = tr + '1';
-    if (p) {
-        move_s[4] = promote_pieces[p];
-        move_s[5] = '\0';
-    } else {
-        move_s[4] = '\0';
-    }
-    if (!strcmp(move_s, "e1h1")) {
-        strcpy(move_s, "e1g1");
-    } else if (!strcmp(move_s, "e1a1")) {
-        strcpy(move_s, "e1c1");
-    } else if (!strcmp(move_s, "e8h8")) {
-        strcpy(move_s, "e8g8");
-    } else if (!strcmp(move_s, "e8a8")) {
-        strcpy(move_s, "e8c8");
-    }
+// polyglot: to | from << 6 | promotion << 12 with a1 = 0 and the promotion 1..4, castles are king takes rook
+_TpackedMove OpenBook::toPackedMove(const unsigned short move) {
+    const int t = move & 077;
+    const int f = (move >> 6) & 077;
+    const int p = (move >> 12) & 0x7;
+    const int from = (f & ~7) | (7 - (f & 7));
+    int to = (t & ~7) | (7 - (t & 7));
+    int kind = p ? PACKED_PROMOTION : PACKED_STANDARD;
+    if ((from == 3 && (to == 0 || to == 7)) || (from == 59 && (to == 56 || to == 63))) {
+        kind = PACKED_CASTLE;
+        to = to < from ? from - 2 : from + 2;
+    }
+    return (_TpackedMove) (from | (to << 6) | ((p ? p - 1 : 0) << 12) | (kind << 14));
 }
 
-string OpenBook::search(string fen) {
+_TpackedMove OpenBook::search(string fen) {
     u64 key = createKey(fen);
     entry_t entry;
-    char move_s[6];
     findKey(key, &entry);
     if (entry.key != key) {
-        return string();
+        return NO_PACKED_MOVE;
     }
-    moveToString(move_s, entry.move);
-    return move_s;
+    return toPackedMove(entry.move);
 }
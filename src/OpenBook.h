@@ -50,7 +50,7 @@ public:
     virtual ~OpenBook();
 
 
-    string search(string fen);
+    _TpackedMove search(string fen);
 
     void dispose();
 
@@ -74,7 +74,7 @@ private:
 
     int findKey(u64 key, entry_t *entry);
 
-    void moveToString(char move_s[6], unsigned short move);
+    _TpackedMove toPackedMove(const unsigned short move);
 
     u64 *Random64;
 };
@@ -82,6 +82,7 @@ Search::Search() : ponder(false), nullSearch(false) {
 
 void Search::clone(const Search *s) {
     memcpy(chessboard, s->chessboard, sizeof(_Tchessboard));
+    memcpy(mailbox, s->mailbox, sizeof(mailbox));
 }
 
 int Search::printDtm() {
@@ -100,7 +101,7 @@ int Search::printDtm() {
     int best = -_INFINITE;
     for (int i = 0; i < getListSize(); i++) {
         move = &gen_list[listId].moveList[i];
-        makemove(move, false, false);
+        makemove(move, false);
         cout << "\n" << decodeBoardinv(move->type, move->from, getSide()) << decodeBoardinv(move->type, move->to, getSide()) << " ";
         res = side ? -getGtb().getDtm<BLACK, true>(chessboard, chessboard[RIGHT_CASTLE_IDX], 100) : getGtb().getDtm<WHITE, true>(chessboard, chessboard[RIGHT_CASTLE_IDX], 100);
         if (res != -INT_MAX) {
@@ -191,30 +192,68 @@ int Search::quiescence(int alpha, int beta, const char promotionPiece, int N_PIE
 
     incListId();
 
-    u64 friends = getBitmap<side>();
-    u64 enemies = getBitmap<side ^ 1>();
-    if (generateCaptures<side>(enemies, friends)) {
-        decListId();
-
-        return _INFINITE - (mainDepth + depth);
-    }
-    if (!getListSize()) {
-        --listId;
-        return score;
-    }
-    _Tmove *move;
-    _Tmove *best = nullptr;
-    u64 oldKey = chessboard[ZOBRISTKEY_IDX];
+    const u64 friends = getBitmap<side>();
+    const u64 enemies = getBitmap<side ^ 1>();
+    setLegalMask<side>(friends, friends | enemies);
+    ///the capture from the hash is searched before the generation
+    _Tmove hashMove;
+    _Tmove *move = nullptr;
+    _TpackedMove packedHashMove = NO_PACKED_MOVE;
     if (checkHashStruct.hashFlag[Hash::HASH_GREATER]) {
-        sortHashMoves(listId, checkHashStruct.phasheType[Hash::HASH_GREATER]);
+        packedHashMove = checkHashStruct.phasheType[Hash::HASH_GREATER].move;
     } else if (checkHashStruct.hashFlag[Hash::HASH_ALWAYS]) {
-        sortHashMoves(listId, checkHashStruct.phasheType[Hash::HASH_ALWAYS]);
+        packedHashMove = checkHashStruct.phasheType[Hash::HASH_ALWAYS].move;
     }
-    while ((move = getNextMove(&gen_list[listId]))) {
-        if (!makemove(move, false, true)) {
+    if (packedHashMove != NO_PACKED_MOVE && isPseudoLegal<side>(packedHashMove, &hashMove) && hashMove.capturedPiece != SQUARE_FREE &&
+        !isBadCapture<side>(&hashMove) && isLegal<side>(&hashMove)) {
+        move = &hashMove;
+    } else {
+        packedHashMove = NO_PACKED_MOVE;
+    }
+    ///as the generation does, the en passant square is cleared before the moves are made
+    const int enpassant = (int) chessboard[ENPASSANT_IDX];
+    if (enpassant != NO_ENPASSANT) {
+        updateZobristKey(13, enpassant);
+        chessboard[ENPASSANT_IDX] = NO_ENPASSANT;
+    }
+    bool hashMoveFirst = move != nullptr;
+    bool generated = false;
+    _TpickRange range = {0, 0, 0};
+    _Tmove *best = nullptr;
+    const u64 oldKey = chessboard[ZOBRISTKEY_IDX];
+    while (true) {
+        if (hashMoveFirst) {
+            hashMoveFirst = false;
+        } else {
+            if (!generated) {
+                generated = true;
+                if (enpassant != NO_ENPASSANT) {
+                    chessboard[ENPASSANT_IDX] = enpassant;
+                    updateZobristKey(13, enpassant);
+                }
+                if (generateCaptures<side, false>(enemies, friends)) {
+                    decListId();
+                    return _INFINITE - (mainDepth + depth);
+                }
+                ASSERT(oldKey == chessboard[ZOBRISTKEY_IDX]);
+                if (!getListSize() && packedHashMove == NO_PACKED_MOVE) {
+                    --listId;
+                    return score;
+                }
+                range = {0, getListSize(), 0};
+            }
+            if (!(move = getNextMove(&gen_list[listId], range, false))) {
+                break;
+            }
+            if (isBadCapture<side>(move) || (packedHashMove != NO_PACKED_MOVE && packMove(move) == packedHashMove)) {
+                continue;
+            }
+        }
+        if (!makemove(move, false)) {
             takeback(move, oldKey, false);
             continue;
         }
+        prefetchHash(chessboard[ZOBRISTKEY_IDX] ^ _random::RANDSIDE[side ^ 1]);
 /**************Delta Pruning ****************/
         if (fprune && ((move->type & 0x3) != PROMOTION_MOVE_MASK) && fscore + PIECES_VALUE[move->capturedPiece] <= alpha) {
             INC(nCutFp);
@@ -230,7 +269,7 @@ int Search::quiescence(int alpha, int beta, const char promotionPiece, int N_PIE
                 decListId();
                 ASSERT(checkHashStruct.rootHash[Hash::HASH_GREATER]);
                 ASSERT(checkHashStruct.rootHash[Hash::HASH_ALWAYS]);
-                recordHash<smp>(getRunning(), checkHashStruct.rootHash, depth, Hash::hashfBETA, zobristKeyR, score, move);
+                recordHash<smp>(getRunning(), checkHashStruct.rootHash, depth, Hash::hashfBETA, zobristKeyR, score, packMove(move));
                 return beta;
             }
             best = move;
@@ -240,7 +279,7 @@ int Search::quiescence(int alpha, int beta, const char promotionPiece, int N_PIE
     }
     ASSERT(checkHashStruct.rootHash[Hash::HASH_GREATER]);
     ASSERT(checkHashStruct.rootHash[Hash::HASH_ALWAYS]);
-    recordHash<smp>(getRunning(), checkHashStruct.rootHash, depth, hashf, zobristKeyR, score, best);
+    recordHash<smp>(getRunning(), checkHashStruct.rootHash, depth, hashf, zobristKeyR, score, best ? packMove(best) : NO_PACKED_MOVE);
 
     decListId();
 
@@ -272,43 +311,15 @@ int Search::getMaxTimeMillsec() {
     return maxTimeMillsec;
 }
 
-void Search::sortHashMoves(int listId1, Hash::_Thash &phashe) {
-    for (int r = 0; r < gen_list[listId1].size; r++) {
-        _Tmove *mos = &gen_list[listId1].moveList[r];
-
-        if (phashe.from == mos->from && phashe.to == mos->to) {
-            mos->score = _INFINITE / 2;
-            return;
-        }
-    }
-}
-
-bool Search::checkInsufficientMaterial(int N_PIECE) {
-    //regexp: KN?B*KB*
-    if (N_PIECE > 6) {
-        return false;
-    }
-    // KK
-    if (N_PIECE == 2) {
+bool Search::checkInsufficientMaterial() {
+    const _Tmaterial &m = getMaterial();
+    if (m.flags & MATERIAL_DRAW) {
         return true;
     }
-    if (!chessboard[PAWN_BLACK] && !chessboard[PAWN_WHITE] && !chessboard[ROOK_BLACK] && !chessboard[ROOK_WHITE] && !chessboard[QUEEN_WHITE] && !chessboard[QUEEN_BLACK]) {
-        u64 allBishop = chessboard[BISHOP_BLACK] | chessboard[BISHOP_WHITE];
-        u64 allKnight = chessboard[KNIGHT_BLACK] | chessboard[KNIGHT_WHITE];
-        if (allBishop || allKnight) {
-            //insufficient material to mate
-            if (!allKnight) {
-                //regexp: KB+KB*
-                if ((bitCount(allBishop) == 1) || ((allBishop & BLACK_SQUARES) == allBishop || (allBishop & WHITE_SQUARES) == allBishop)) {
-                    return true;
-                }
-            } else {
-                //KNKN*
-                if (!allBishop && bitCount(allKnight) < 3) {
-                    return true;
-                }
-            }
-        }
+    if (m.flags & MATERIAL_BISHOPS_ONLY) {
+        //regexp: KB+KB* all on the same colour
+        const u64 allBishop = chessboard[BISHOP_BLACK] | chessboard[BISHOP_WHITE];
+        return (allBishop & BLACK_SQUARES) == allBishop || (allBishop & WHITE_SQUARES) == allBishop;
     }
     return false;
 }
@@ -355,17 +366,19 @@ void Search::setMainParam(const bool smp, const int depth) {
 
 int Search::search(bool smp, int depth, int alpha, int beta) {
     ASSERT_RANGE(depth, 0, MAX_PLY);
+    // the generation takes the en passant square off the root, the next iteration and the best move need it back
+    const u64 enpassant = chessboard[ENPASSANT_IDX];
+    const u64 key = chessboard[ZOBRISTKEY_IDX];
+    const int nPieces = bitCount(getAllPieces());
+    int res;
     if (smp) {
-        return getSide() ? search<WHITE, SMP_YES>(depth, alpha, beta, &pvLine, bitCount(getBitmap<WHITE>() | getBitmap<BLACK>()), &mainMateIn) : search<BLACK, SMP_YES>(depth, alpha, beta, &pvLine,
-                                                                                                                                                                        bitCount(getBitmap<WHITE>() |
-                                                                                                                                                                                 getBitmap<BLACK>()),
-                                                                                                                                                                        &mainMateIn);
+        res = getSide() ? search<WHITE, SMP_YES>(depth, alpha, beta, &pvLine, nPieces, &mainMateIn) : search<BLACK, SMP_YES>(depth, alpha, beta, &pvLine, nPieces, &mainMateIn);
     } else {
-        return getSide() ? search<WHITE, SMP_NO>(depth, alpha, beta, &pvLine, bitCount(getBitmap<WHITE>() | getBitmap<BLACK>()), &mainMateIn) : search<BLACK, SMP_NO>(depth, alpha, beta, &pvLine,
-                                                                                                                                                                      bitCount(getBitmap<WHITE>() |
-                                                                                                                                                                               getBitmap<BLACK>()),
-                                                                                                                                                                      &mainMateIn);
+        res = getSide() ? search<WHITE, SMP_NO>(depth, alpha, beta, &pvLine, nPieces, &mainMateIn) : search<BLACK, SMP_NO>(depth, alpha, beta, &pvLine, nPieces, &mainMateIn);
     }
+    chessboard[ENPASSANT_IDX] = enpassant;
+    chessboard[ZOBRISTKEY_IDX] = key;
+    return res;
 }
 
 
@@ -398,7 +411,6 @@ int Search::search(int depth, int alpha, int beta, _TpvLine *pline, int N_PIECE,
             return res;
         }
     }
-    u64 oldKey = chessboard[ZOBRISTKEY_IDX];
 #ifdef DEBUG_MODE
     double betaEfficiencyCount = 0.0;
 #endif
@@ -406,9 +418,11 @@ int Search::search(int depth, int alpha, int beta, _TpvLine *pline, int N_PIECE,
     ASSERT(chessboard[KING_WHITE]);
     ASSERT(chessboard[KING_BLACK + side]);
     int extension = 0;
-    int is_incheck_side = inCheck<side>();
+    ///checkers of the side to move, the move picker reuses them for the legality of the ply
+    const u64 checkers = getAllAttackers<side>(BITScanForward(chessboard[KING_BLACK + side]), getAllPieces());
+    int is_incheck_side = checkers != 0;
     if (!is_incheck_side && depth != mainDepth) {
-        if (checkInsufficientMaterial(N_PIECE) || checkDraw(chessboard[ZOBRISTKEY_IDX])) {
+        if (checkInsufficientMaterial() || checkDraw(chessboard[ZOBRISTKEY_IDX])) {
             if (inCheck<side ^ 1>()) {
                 return _INFINITE - (mainDepth - depth + 1);
             }
@@ -442,10 +456,11 @@ int Search::search(int depth, int alpha, int beta, _TpvLine *pline, int N_PIECE,
     ++numMoves;
     ///********* null move ***********
     int n_pieces_side;
-    _TpvLine line;
+    ///the null move search runs before incListId, its nodes take the next line of the stack
+    _TpvLine &line = pvStack[listId + 1 + nullSearch];
     line.cmove = 0;
 
-    if (!is_incheck_side && !nullSearch && depth >= NULLMOVE_DEPTH && (n_pieces_side = getNpiecesNoPawnNoKing<side>()) >= NULLMOVES_MIN_PIECE) {
+    if (!is_incheck_side && !nullSearch && depth >= NULLMOVE_DEPTH && (n_pieces_side = getMaterial().pieces[side]) >= NULLMOVES_MIN_PIECE) {
         nullSearch = true;
         int nullScore = -search<side ^ 1, smp>(depth - (NULLMOVES_R1 + (depth > (NULLMOVES_R2 + (n_pieces_side < NULLMOVES_R3 ? NULLMOVES_R4 : 0)))) - 1, -beta, -beta + 1, &line, N_PIECE, mateIn);
         nullSearch = false;
@@ -462,7 +477,7 @@ int Search::search(int depth, int alpha, int beta, _TpvLine *pline, int N_PIECE,
     if (depth <= 3 && !is_incheck_side) {
         int matBalance = lazyEval<side>();
         if ((futilScore = matBalance + FUTIL_MARGIN) <= alpha) {
-            if (depth == 3 && (matBalance + RAZOR_MARGIN) <= alpha && getNpiecesNoPawnNoKing<side ^ 1>() > 3) {
+            if (depth == 3 && (matBalance + RAZOR_MARGIN) <= alpha && getMaterial().pieces[side ^ 1] > 3) {
                 INC(nCutRazor);
                 depth--;
             } else
@@ -482,43 +497,31 @@ int Search::search(int depth, int alpha, int beta, _TpvLine *pline, int N_PIECE,
     incListId();
     ASSERT_RANGE(KING_BLACK + side, 0, 11);
     ASSERT_RANGE(KING_BLACK + (side ^ 1), 0, 11);
-    u64 friends = getBitmap<side>();
-    u64 enemies = getBitmap<side ^ 1>();
-    if (generateCaptures<side>(enemies, friends)) {
-        decListId();
-        score = _INFINITE - (mainDepth - depth + 1);
-        return score;
-    }
-    generateMoves<side>(friends | enemies);
-    int listcount = getListSize();
-    if (!listcount) {
-        --listId;
-        if (is_incheck_side) {
-            return -_INFINITE + (mainDepth - depth + 1);
-        } else {
-            return -lazyEval<side>() * 2;
-        }
-    }
-    _Tmove *best = nullptr;
+    _TmovePicker picker;
     if (checkHashStruct.hashFlag[Hash::HASH_GREATER]) {
-        sortHashMoves(listId, checkHashStruct.phasheType[Hash::HASH_GREATER]);
+        initMovePicker<side>(picker, checkHashStruct.phasheType[Hash::HASH_GREATER].move, checkers);
     } else if (checkHashStruct.hashFlag[Hash::HASH_ALWAYS]) {
-        sortHashMoves(listId, checkHashStruct.phasheType[Hash::HASH_ALWAYS]);
+        initMovePicker<side>(picker, checkHashStruct.phasheType[Hash::HASH_ALWAYS].move, checkers);
+    } else {
+        initMovePicker<side>(picker, NO_PACKED_MOVE, checkers);
     }
+    u64 oldKey = chessboard[ZOBRISTKEY_IDX];
+    _Tmove *best = nullptr;
     INC(totGen);
     _Tmove *move;
-    bool checkInCheck = false;
     int countMove = 0;
     char hashf = Hash::hashfALPHA;
-    while ((move = getNextMove(&gen_list[listId]))) {
+    while ((move = getNextMove<side>(picker))) {
         countMove++;
         INC(betaEfficiencyCount);
-        if (!makemove(move, true, checkInCheck)) {
+        if (!makemove(move, true)) {
             takeback(move, oldKey, true);
             continue;
         }
-        checkInCheck = true;
-        if (futilPrune && ((move->type & 0x3) != PROMOTION_MOVE_MASK) && futilScore + PIECES_VALUE[move->capturedPiece] <= alpha && !inCheck<side>()) {
+        prefetchHash(chessboard[ZOBRISTKEY_IDX] ^ _random::RANDSIDE[side ^ 1]);
+        ///the moves are legal, the king of side is never left in check
+        ASSERT(!inCheck<side>());
+        if (futilPrune && ((move->type & 0x3) != PROMOTION_MOVE_MASK) && futilScore + PIECES_VALUE[move->capturedPiece] <= alpha) {
             INC(nCutFp);
             takeback(move, oldKey, true);
             continue;
@@ -547,37 +550,46 @@ int Search::search(int depth, int alpha, int beta, _TpvLine *pline, int N_PIECE,
         }
         score = max(score, val);
         takeback(move, oldKey, true);
-        move->score = score;
         if (score > alpha) {
             if (score >= beta) {
+                ADD(betaEfficiency, betaEfficiencyCount / (double) max(1, getListSize()) * 100.0);
+                if (move->capturedPiece == SQUARE_FREE && move->promotionPiece == NO_PROMOTION && !(move->type & 0xc)) {
+                    setKiller(move);
+                }
                 decListId();
-                ASSERT(move->score == score);
                 INC(nCutAB);
-                ADD(betaEfficiency, betaEfficiencyCount / (double) listcount * 100.0);
                 ASSERT(checkHashStruct.rootHash[Hash::HASH_GREATER]);
                 ASSERT(checkHashStruct.rootHash[Hash::HASH_ALWAYS]);
-                recordHash<smp>(getRunning(), checkHashStruct.rootHash, depth - extension, Hash::hashfBETA, zobristKeyR, score, move);
+                recordHash<smp>(getRunning(), checkHashStruct.rootHash, depth - extension, Hash::hashfBETA, zobristKeyR, score, packMove(move));
                 setKillerHeuristic(move->from, move->to, 0x400);
                 return score;
             }
             alpha = score;
             hashf = Hash::hashfEXACT;
             best = move;
-            move->score = score;    //used in it
-            updatePv(pline, &line, move);
+            updatePv(pline, &line, move, score);
+        }
+    }
+    if (!countMove) {
+        decListId();
+        if (is_incheck_side) {
+            return -_INFINITE + (mainDepth - depth + 1);
+        } else {
+            return -lazyEval<side>() * 2;
         }
     }
     ASSERT(checkHashStruct.rootHash[Hash::HASH_GREATER]);
     ASSERT(checkHashStruct.rootHash[Hash::HASH_ALWAYS]);
-    recordHash<smp>(getRunning(), checkHashStruct.rootHash, depth - extension, hashf, zobristKeyR, score, best);
+    recordHash<smp>(getRunning(), checkHashStruct.rootHash, depth - extension, hashf, zobristKeyR, score, best ? packMove(best) : NO_PACKED_MOVE);
     decListId();
     return score;
 }
 
-void Search::updatePv(_TpvLine *pline, const _TpvLine *line, const _Tmove *move) {
+void Search::updatePv(_TpvLine *pline, const _TpvLine *line, const _Tmove *move, const int score) {
     ASSERT(line->cmove < MAX_PLY - 1);
-    memcpy(&(pline->argmove[0]), move, sizeof(_Tmove));
-    memcpy(pline->argmove + 1, line->argmove, line->cmove * sizeof(_Tmove));
+    pline->score = score;
+    pline->argmove[0] = packMove(move);
+    memcpy(pline->argmove + 1, line->argmove, line->cmove * sizeof(_TpackedMove));
     ASSERT(line->cmove >= 0);
     pline->cmove = line->cmove + 1;
 }
@@ -588,6 +600,7 @@ _Tchessboard &Search::getChessboard() {
 
 void Search::setChessboard(_Tchessboard &b) {
     memcpy(chessboard, b, sizeof(chessboard));
+    initMailbox();
 }
 
 u64 Search::getZobristKey() {
@@ -150,14 +150,12 @@ private:
     template<int side, bool smp>
     int search(int depth, int alpha, int beta, _TpvLine *pline, int N_PIECE, int *mateIn);
 
-    bool checkInsufficientMaterial(int);
-
-    void sortHashMoves(int listId, Hash::_Thash &);
+    bool checkInsufficientMaterial();
 
     template<int side, bool smp>
     int quiescence(int alpha, int beta, const char promotionPiece, int, int depth);
 
-    void updatePv(_TpvLine *pline, const _TpvLine *line, const _Tmove *move);
+    void updatePv(_TpvLine *pline, const _TpvLine *line, const _Tmove *move, const int score);
 
     int mainMateIn;
     int mainDepth;
@@ -174,28 +172,30 @@ private:
 
 
         if (readHash<smp, type>(checkHashStruct.rootHash, zobristKeyR, phashe)) {
-            if (phashe->from != phashe->to && phashe->flags & 0x3) {    // hashfEXACT or hashfBETA
+            if (phashe->move != NO_PACKED_MOVE && phashe->flags & 0x3) {    // hashfEXACT or hashfBETA
                 checkHashStruct.hashFlag[type] = true;
             }
             if (phashe->depth >= depth) {
                 INC(probeHash);
                 if (!currentPly) {
                     if (phashe->flags == Hash::hashfBETA) {
-                        incKillerHeuristic(phashe->from, phashe->to, 1);
+                        incKillerHeuristic(phashe->move & 0x3f, (phashe->move >> 6) & 0x3f, 1);
                     }
                 } else {
                     switch (phashe->flags) {
                         case Hash::hashfEXACT:
                             if (phashe->score >= beta) {
                                 INC(n_cut_hashB);
+                                hashStats.cut++;
                                 checkHashStruct.res = beta;
                                 return true;
                             }
                             break;
                         case Hash::hashfBETA:
-                            if (!quies)incKillerHeuristic(phashe->from, phashe->to, 1);
+                            if (!quies)incKillerHeuristic(phashe->move & 0x3f, (phashe->move >> 6) & 0x3f, 1);
                             if (phashe->score >= beta) {
                                 INC(n_cut_hashB);
+                                hashStats.cut++;
                                 checkHashStruct.res = beta;
                                 return true;
                             }
@@ -203,6 +203,7 @@ private:
                         case Hash::hashfALPHA:
                             if (phashe->score <= alpha) {
                                 INC(n_cut_hashA);
+                                hashStats.cut++;
                                 checkHashStruct.res = alpha;
                                 return true;
                             }
@@ -111,30 +111,29 @@ void SearchManager::receiveObserverSearch(const int threadID) {
     spinlockSearch.unlock();
 }
 
-bool SearchManager::getRes(_Tmove &resultMove, string &ponderMove, string &pvv, int *mateIn1) {
+bool SearchManager::getRes(_Tmove &resultMove, int &score, string &ponderMove, string &pvv, int *mateIn1) {
     if (lineWin.cmove < 1) {
         return false;
     }
+    // the pv was searched from this position, on failure the outputs are left untouched
+    const bool unpacked = getThread(0).unpackMove(lineWin.argmove[0], &resultMove);
+    ASSERT(unpacked);
+    if (!unpacked) {
+        return false;
+    }
 
     *mateIn1 = mateIn;
     pvv.clear();
-    string pvvTmp;
 
-    ASSERT(lineWin.cmove);
     for (int t = 0; t < lineWin.cmove; t++) {
-        pvvTmp.clear();
-        pvvTmp += Search::decodeBoardinv(lineWin.argmove[t].type, lineWin.argmove[t].from, getThread(0).getSide());
-        if (pvvTmp.length() != 4) {
-            pvvTmp += Search::decodeBoardinv(lineWin.argmove[t].type, lineWin.argmove[t].to, getThread(0).getSide());
-        }
+        const string pvvTmp = Search::packedMoveToString(lineWin.argmove[t]);
         pvv.append(pvvTmp);
         if (t == 1) {
             ponderMove.assign(pvvTmp);
         }
         pvv.append(" ");
     };
-    memcpy(&resultMove, lineWin.argmove, sizeof(_Tmove));
-
+    score = lineWin.score;
     return true;
 }
 
@@ -146,7 +145,7 @@ int SearchManager::loadFen(string fen) {
 
     ASSERT_RANGE(res, 0, 1);
     for (uchar i = 1; i < getPool().size(); i++) {
-        getThread(i).setChessboard(getThread(0).getChessboard());
+        getPool()[i]->setChessboard(getThread(0).getChessboard());
     }
     return res;
 }
@@ -202,8 +201,12 @@ void SearchManager::clearKillerHeuristic() {
     }
 }
 
-void SearchManager::clearAge() {
-    getThread(0).clearAge();
+void SearchManager::newGeneration() {
+    getThread(0).newGeneration();
+    for (Search *s:getPool()) {
+        s->hashStats = {};
+        s->evalStats = {};
+    }
 }
 
 int SearchManager::getForceCheck() {
@@ -244,6 +247,81 @@ void SearchManager::setHashSize(int s) {
     getThread(0).setHashSize(s);
 }
 
+bool SearchManager::setSharedHash(const string &name) {
+    if (!getThread(0).setSharedHash(name)) {
+        return false;
+    }
+    setHashSize(getHashSize());
+    return true;
+}
+
+void SearchManager::setLargePages(bool b) {
+    getThread(0).setLargePages(b);
+    setHashSize(getHashSize());
+}
+
+string SearchManager::getHashAllocInfo() {
+    return getThread(0).getAllocInfo();
+}
+
+int SearchManager::getHashFull() {
+    return getThread(0).getHashFull();
+}
+
+void SearchManager::printHashStats() {
+    Hash::_ThashStats stats = {};
+    for (Search *s:getPool()) {
+        stats.probe += s->hashStats.probe;
+        stats.hit[Hash::HASH_GREATER] += s->hashStats.hit[Hash::HASH_GREATER];
+        stats.hit[Hash::HASH_ALWAYS] += s->hashStats.hit[Hash::HASH_ALWAYS];
+        stats.cut += s->hashStats.cut;
+        stats.store += s->hashStats.store;
+        stats.collision += s->hashStats.collision;
+    }
+    Eval::_TevalStats evalStats = {};
+    for (Search *s:getPool()) {
+        evalStats.probe += s->evalStats.probe;
+        evalStats.hit += s->evalStats.hit;
+        evalStats.lazy += s->evalStats.lazy;
+    }
+    const u64 probe = max(stats.probe, 1ULL);
+    cout << "info string " << getHashAllocInfo() << ", hashfull " << getHashFull() << "\n";
+    cout << "info string last search probe " << stats.probe << " hit " << (stats.hit[Hash::HASH_GREATER] + stats.hit[Hash::HASH_ALWAYS]) * 100 / probe << "% (always=" << stats.hit[Hash::HASH_GREATER] * 100 / probe << "% depth=" << stats.hit[Hash::HASH_ALWAYS] * 100 / probe << "%) cut " << stats.cut * 100 / probe << "% store " << stats.store << " collision " << stats.collision << "\n";
+    cout << "info string last search eval cache probe " << evalStats.probe << " hit " << evalStats.hit * 100 / max(evalStats.probe, 1ULL) << "% lazy " << evalStats.lazy << "\n";
+
+    u64 histogram[Hash::HISTOGRAM_DEPTH][Hash::HISTOGRAM_AGE];
+    getThread(0).getHashHistogram(histogram);
+    cout << "info string depth/age histogram (depth 0 includes quiescence, last age column is " << Hash::HISTOGRAM_AGE - 1 << "+)\n";
+    cout << "info string depth";
+    for (int age = 0; age < Hash::HISTOGRAM_AGE; age++) {
+        cout << setw(10) << age;
+    }
+    cout << "\n";
+    for (int depth = 0; depth < Hash::HISTOGRAM_DEPTH; depth++) {
+        u64 tot = 0;
+        for (int age = 0; age < Hash::HISTOGRAM_AGE; age++) {
+            tot += histogram[depth][age];
+        }
+        if (!tot) {
+            continue;
+        }
+        cout << "info string " << setw(5) << depth;
+        for (int age = 0; age < Hash::HISTOGRAM_AGE; age++) {
+            cout << setw(10) << histogram[depth][age];
+        }
+        cout << "\n";
+    }
+    cout << flush;
+}
+
+bool SearchManager::saveHash(const string &file) {
+    return getThread(0).saveHash(file);
+}
+
+bool SearchManager::loadHash(const string &file) {
+    return getThread(0).loadHash(file);
+}
+
 void SearchManager::setMaxTimeMillsec(int i) {
     for (Search *s:getPool()) {
         s->setMaxTimeMillsec(i);
@@ -269,7 +347,7 @@ int SearchManager::getSide() {
 int SearchManager::getScore(int side, const bool trace) {
     int N_PIECE = 0;
 #ifdef DEBUG_MODE
-    N_PIECE = bitCount(getThread(0).getBitmap<WHITE>() | getThread(0).getBitmap<BLACK>());
+    N_PIECE = bitCount(getThread(0).getAllPieces());
 #endif
     return getThread(0).getScore(side, N_PIECE, -_INFINITE, _INFINITE, trace);
 }
@@ -322,6 +400,18 @@ int SearchManager::getMoveFromSan(String string, _Tmove *ptr) {
     return getThread(0).getMoveFromSan(string, ptr);
 }
 
+bool SearchManager::unpackMove(const _TpackedMove packed, _Tmove *move) {
+    return getThread(0).unpackMove(packed, move);
+}
+
+bool SearchManager::isPseudoLegal(const _TpackedMove packed, _Tmove *move) {
+    return getThread(0).isPseudoLegal(packed, move);
+}
+
+bool SearchManager::isLegal(const _Tmove *move) {
+    return getThread(0).isLegal(move);
+}
+
 Tablebase &SearchManager::getGtb() {
     return getThread(0).getGtb();
 }
@@ -33,7 +33,7 @@ class SearchManager : public Singleton<SearchManager>, public ThreadPool<Search>
 
 public:
 
-    bool getRes(_Tmove &resultMove, string &ponderMove, string &pvv, int *mateIn);
+    bool getRes(_Tmove &resultMove, int &score, string &ponderMove, string &pvv, int *mateIn);
 
     ~SearchManager();
 
@@ -59,7 +59,7 @@ public:
 
     void clearKillerHeuristic();
 
-    void clearAge();
+    void newGeneration();
 
     int getForceCheck();
 
@@ -81,6 +81,20 @@ public:
 
     void setHashSize(int s);
 
+    void setLargePages(bool b);
+
+    bool setSharedHash(const string &name);
+
+    string getHashAllocInfo();
+
+    bool saveHash(const string &file);
+
+    int getHashFull();
+
+    void printHashStats();
+
+    bool loadHash(const string &file);
+
     void setMaxTimeMillsec(int i);
 
     void setPonder(bool i);
@@ -105,6 +119,12 @@ public:
 
     int getMoveFromSan(String string, _Tmove *ptr);
 
+    bool unpackMove(const _TpackedMove packed, _Tmove *move);
+
+    bool isPseudoLegal(const _TpackedMove packed, _Tmove *move);
+
+    bool isLegal(const _Tmove *move);
+
     int printDtm();
 
     void setGtb(Tablebase &tablebase);
@@ -31,6 +31,7 @@ void Uci::startListner() {
 }
 
 Uci::Uci() {
+    cout << "info string " << searchManager.getHashAllocInfo() << endl;
     startListner();
 }
 
@@ -90,6 +91,27 @@ void Uci::listner(IterativeDeeping *it) {
             knowCommand = true;
         }
 
+        else if (token == "savehash" || token == "loadhash") {
+            knowCommand = true;
+            while (it->getRunning());
+            string file;
+            uip >> file;
+            const bool save = token == "savehash";
+            if (file.empty()) {
+                cout << "info string error - missing file name" << endl;
+            } else if (save ? searchManager.saveHash(file) : searchManager.loadHash(file)) {
+                cout << "info string " << (save ? "saved " : "loaded ") << searchManager.getHashAllocInfo() << endl;
+            } else {
+                cout << "info string error - " << (save ? "save" : "load") << " hash " << file << endl;
+            }
+        }
+
+        else if (token == "hashstats") {
+            knowCommand = true;
+            while (it->getRunning());
+            searchManager.printHashStats();
+        }
+
         else if (token == "dump") {
             knowCommand = true;
             if (perft)perft->dump();
@@ -115,8 +137,10 @@ void Uci::listner(IterativeDeeping *it) {
             uciMode = true;
             cout << "id name " << NAME << "\n";
             cout << "id author Giuseppe Cannella\n";
-            cout << "option name Hash type spin default 64 min 1 max 1000\n";
+            cout << "option name Hash type spin default 64 min 1 max 262144\n";
             cout << "option name Clear Hash type button\n";
+            cout << "option name Large Pages type check default true\n";
+            cout << "option name SharedHash type string default <empty>\n";
             cout << "option name Nullmove type check default true\n";
             cout << "option name Book File type string default cinnamon.bin\n";
             cout << "option name OwnBook type check default " << _BOOLEAN[it->getUseBook()] << "\n";
@@ -262,6 +286,28 @@ void Uci::listner(IterativeDeeping *it) {
                         searchManager.setHashSize(stoi(token));
                         knowCommand = true;
                     }
+                } else if (token == "large") {
+                    getToken(uip, token);
+                    if (token == "pages") {
+                        getToken(uip, token);
+                        if (token == "value") {
+                            getToken(uip, token);
+                            searchManager.setLargePages(token == "true");
+                            cout << "info string " << searchManager.getHashAllocInfo() << endl;
+                            knowCommand = true;
+                        }
+                    }
+                } else if (token == "sharedhash") {
+                    getToken(uip, token);
+                    if (token == "value") {
+                        string name;
+                        uip >> name;
+                        if (name == "<empty>") {
+                            name.clear();
+                        }
+                        knowCommand = searchManager.setSharedHash(name);
+                        cout << "info string " << searchManager.getHashAllocInfo() << endl;
+                    }
                 } else if (token == "nullmove") {
                     getToken(uip, token);
                     if (token == "value") {
@@ -69,6 +69,13 @@ namespace _board {
 
     static constexpr array<int, 13> PIECES_VALUE = {VALUEPAWN, VALUEPAWN, VALUEROOK, VALUEROOK, VALUEBISHOP, VALUEBISHOP, VALUEKNIGHT, VALUEKNIGHT, VALUEKING, VALUEKING, VALUEQUEEN, VALUEQUEEN, 0};
 
+    // material key: the low 32 bits are a mixed radix index on the piece counts (9 pawns, 3 rooks/bishops/knights, 2 queens per side),
+    // the high 32 bits keep one nibble per non pawn piece to detect counts outside the material table
+    static constexpr array<u64, 13> MATERIAL_WEIGHT = {1, 9, (1ULL << 32) | 81, (1ULL << 36) | 243, (1ULL << 40) | 729, (1ULL << 44) | 2187, (1ULL << 48) | 6561, (1ULL << 52) | 19683, 0, 0, (1ULL << 56) | 59049, (1ULL << 60) | 118098, 0};
+    static const int MATERIAL_TABLE_SIZE = 236196;
+    static const u64 MATERIAL_OVERFLOW_ADD = 0x6655555500000000ULL;
+    static const u64 MATERIAL_OVERFLOW_MASK = 0x8888888800000000ULL;
+
     static const u64 CENTER_MASK = 0x1818000000ULL;
     static const u64 BIG_DIAGONAL = 0x102040810204080ULL;
     static const u64 BIG_ANTIDIAGONAL = 0x8040201008040201ULL;
@@ -82,18 +89,30 @@ namespace _board {
         uchar to;
         char side;
         uchar type;
-        int score;
-        bool used;
     } _Tmove;
 
+    // the move lists keep the scores in a parallel array, the moves stay 8 bytes
     typedef struct {
         _Tmove *moveList;
+        int *score;
         int size;
     } _TmoveP;
 
+    // from | to << 6 | promotion << 12 | kind << 14, the promotion is knight, bishop, rook or queen (0..3).
+    // Used by the hash table, the principal variation, the killers and the opening book, 0 is no move
+    typedef unsigned short _TpackedMove;
+
+    static const int PACKED_STANDARD = 0;
+    static const int PACKED_PROMOTION = 1;
+    static const int PACKED_ENPASSANT = 2;
+    static const int PACKED_CASTLE = 3;
+    static const _TpackedMove NO_PACKED_MOVE = 0;
+    static constexpr array<int, 4> PACKED_PROMOTION_PIECE = {KNIGHT_BLACK, BISHOP_BLACK, ROOK_BLACK, QUEEN_BLACK};
+
     typedef struct {
         int cmove;
-        _Tmove argmove[MAX_PLY];
+        int score;
+        _TpackedMove argmove[MAX_PLY];
     } _TpvLine;
 
     static const u64 POW2_0 = 0x1ULL;
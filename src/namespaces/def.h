@@ -32,9 +32,10 @@ namespace _def {
 
     typedef unsigned char uchar;
     typedef long long unsigned u64;
-    typedef u64 _Tchessboard[16];
+    typedef u64 _Tchessboard[21];
 
 #define RESET_LSB(bits) (bits&=bits-1)
+#define PREFETCH(addr) __builtin_prefetch(addr)
 
 #if defined(CLOP) || defined(DEBUG_MODE)
 #define STATIC_CONST
@@ -30,6 +30,8 @@ void PerftThread::setParam(const string &fen1, const int from1, const int to1, _
     this->tPerftRes = perft1;
     this->from = from1;
     this->to = to1;
+    tot = 0;
+    partialTot = 0;
 }
 
 unsigned PerftThread::perft(const string &fen, const int depth) {
@@ -72,7 +74,7 @@ vector<string> PerftThread::getSuccessorsFen(const int depthx) {
     for (int ii = 0; ii < listcount; ii++) {
         move = getMove(ii);
         u64 keyold = chessboard[ZOBRISTKEY_IDX];
-        makemove(move, false, false);
+        makemove(move, false);
         setSide(side ^ 1);
         vector<string> bb = getSuccessorsFen<side ^ 1>(depthx - 1);
         n_perft.insert(n_perft.end(), bb.begin(), bb.end());
@@ -108,27 +110,37 @@ u64 PerftThread::search(const int depthx) {
         }
         if (smp)SPINLOCK_HASH.unlock();
     }
-    int listcount;
-    _Tmove *move;
-    incListId();
-    u64 friends = getBitmap<side>();
-    u64 enemies = getBitmap<side ^ 1>();
-    bool b = generateCaptures<side>(enemies, friends);
-    ASSERT(!b);
-    generateMoves<side>(friends | enemies);
-    listcount = getListSize();
-    if (!listcount) {
+    if (depthx == 1) {
+        //bulk counting: the generator is legal, the leaves are the moves of the list
+        n_perft = countLegalMoves<side>();
+        partialTot += n_perft;
+    } else {
+        int listcount;
+        _Tmove *move;
+        incListId();
+        u64 friends = getBitmap<side>();
+        u64 enemies = getBitmap<side ^ 1>();
+        bool b = generateCaptures<side>(enemies, friends);
+        ASSERT(!b);
+        generateMoves<side>(friends | enemies);
+        listcount = getListSize();
+        if (!listcount) {
+            decListId();
+            return 0;
+        }
+        for (int ii = 0; ii < listcount; ii++) {
+            move = getMove(ii);
+            u64 keyold = chessboard[ZOBRISTKEY_IDX];
+            makemove(move, false);
+            if (useHash) {
+                const u64 key = chessboard[ZOBRISTKEY_IDX] ^ _random::RANDSIDE[side ^ 1];
+                PREFETCH(&(tPerftRes->hash[depthx - 1][key % tPerftRes->sizeAtDepth[depthx - 1]]));
+            }
+            n_perft += search<side ^ 1, useHash, smp>(depthx - 1);
+            takeback(move, keyold, false);
+        }
         decListId();
-        return 0;
     }
-    for (int ii = 0; ii < listcount; ii++) {
-        move = getMove(ii);
-        u64 keyold = chessboard[ZOBRISTKEY_IDX];
-        makemove(move, false, false);
-        n_perft += search<side ^ 1, useHash, smp>(depthx - 1);
-        takeback(move, keyold, false);
-    }
-    decListId();
     if (useHash) {
         if (smp) SPINLOCK_HASH.lock();
         phashe->key = zobristKeyR;
@@ -157,7 +169,7 @@ void PerftThread::run() {
     for (int ii = from; ii <= to - 1; ii++) {
         u64 n_perft = 0;
         move = getMove(ii);
-        makemove(move, false, false);
+        makemove(move, false);
         bool fhash = tPerftRes->hash != nullptr ? true : false;
         bool side = (chessboard[SIDETOMOVE_IDX] ^ 1);
         bool smp = tPerftRes->nCpu == 1 ? false : true;
@@ -31,4 +31,24 @@ TEST(eval, eval1) {
     EXPECT_EQ(-5, score);
 }
 
+TEST(eval, evalCache) {
+    SearchManager &searchManager = Singleton<SearchManager>::getInstance();
+    searchManager.loadFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    const int score = searchManager.getScore(WHITE, false);
+    EXPECT_EQ(score, searchManager.getScore(WHITE, false));
+    const int scoreBlack = searchManager.getScore(BLACK, false);
+    EXPECT_EQ(scoreBlack, searchManager.getScore(BLACK, false));
+}
+
+TEST(eval, material) {
+    SearchManager &searchManager = Singleton<SearchManager>::getInstance();
+    // a bishop alone can't win
+    searchManager.loadFen("8/8/4k3/8/8/3BK3/8/8 w - - 0 1");
+    EXPECT_EQ(0, searchManager.getScore(WHITE, false));
+    // three queens are outside the material table
+    searchManager.loadFen("4k3/8/8/8/8/8/8/QQQ1K3 w - - 0 1");
+    EXPECT_LT(2500, searchManager.getScore(WHITE, false));
+    EXPECT_GT(-2500, searchManager.getScore(BLACK, false));
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,131 @@
+/*
+    Cinnamon UCI chess engine
+    Copyright (C) Giuseppe Cannella
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if defined(DEBUG_MODE) || defined(FULL_TEST)
+
+#include <gtest/gtest.h>
+#include <fstream>
+#include "../IterativeDeeping.h"
+
+static bool probeHash(Search &search, const u64 key, Hash::_Thash *hashMini) {
+    Hash::_Thash *phashe[2];
+    return search.readHash<false, Hash::HASH_GREATER>(phashe, key, hashMini) ||
+           search.readHash<false, Hash::HASH_ALWAYS>(phashe, key, hashMini);
+}
+
+static void storeHash(Search &search, const u64 key, const char depth, const int score) {
+    Hash::_Thash *phashe[2];
+    Hash::_Thash hashMini;
+    search.readHash<false, Hash::HASH_GREATER>(phashe, key, &hashMini);
+    search.readHash<false, Hash::HASH_ALWAYS>(phashe, key, &hashMini);
+    search.recordHash<false>(true, phashe, depth, Hash::hashfEXACT, key, score, 0);
+}
+
+static void copyFile(const string &from, const string &to, const size_t size, const int offset, const char c) {
+    ifstream in(from, ios::binary);
+    string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    data.resize(min(size, data.size()));
+    if (offset >= 0) {
+        data[offset] = c;
+    }
+    ofstream out(to, ios::binary);
+    out.write(data.data(), data.size());
+}
+
+TEST(hash, saveLoad) {
+    const string fen = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -";
+    const string file = "/tmp/cinnamon_test.hash";
+    SearchManager &searchManager = Singleton<SearchManager>::getInstance();
+    const int hashSize = searchManager.getHashSize();
+    searchManager.setHashSize(1);
+
+    IterativeDeeping it;
+    it.loadFen(fen);
+    it.setMaxDepth(6);
+    it.start();
+    it.join();
+
+    searchManager.loadFen(fen);
+    Search &search = searchManager.getThread(0);
+    const u64 key = search.getZobristKey() ^_random::RANDSIDE[searchManager.getSide()];
+    Hash::_Thash saved, loaded;
+    ASSERT_TRUE(probeHash(search, key, &saved));
+
+    ASSERT_TRUE(searchManager.saveHash(file));
+    searchManager.clearHash();
+    EXPECT_FALSE(probeHash(search, key, &loaded));
+    ASSERT_TRUE(searchManager.loadHash(file));
+    ASSERT_TRUE(probeHash(search, key, &loaded));
+    EXPECT_EQ(saved.data, loaded.data);
+    EXPECT_EQ(1, searchManager.getHashSize());
+
+    // truncated file and wrong version are refused, the table in use is kept
+    copyFile(file, file + ".bad", 1000, -1, 0);
+    EXPECT_FALSE(searchManager.loadHash(file + ".bad"));
+    copyFile(file, file + ".bad", -1, 8, '?');
+    EXPECT_FALSE(searchManager.loadHash(file + ".bad"));
+    EXPECT_FALSE(searchManager.loadHash(file + ".missing"));
+    ASSERT_TRUE(probeHash(search, key, &loaded));
+    EXPECT_EQ(saved.data, loaded.data);
+
+    remove(file.c_str());
+    remove((file + ".bad").c_str());
+    searchManager.setHashSize(hashSize);
+    searchManager.loadFen(STARTPOS);
+}
+
+TEST(hash, resize) {
+    SearchManager &searchManager = Singleton<SearchManager>::getInstance();
+    const int hashSize = searchManager.getHashSize();
+    searchManager.setHashSize(1);
+    searchManager.clearHash();
+
+    const int N = 1000;
+    u64 key = 0x9e3779b97f4a7c15ULL;
+    vector<u64> keys;
+    for (int i = 0; i < N; i++) {
+        key ^= key << 13;
+        key ^= key >> 7;
+        key ^= key << 17;
+        keys.push_back(key);
+        storeHash(searchManager.getThread(0), key, i % 64, i);
+    }
+
+    for (const int mb:{4, 2}) {
+        searchManager.setHashSize(mb);
+        ASSERT_EQ(mb, searchManager.getHashSize());
+        Search &search = searchManager.getThread(0);
+        for (int i = 0; i < N; i++) {
+            Hash::_Thash hashMini;
+            ASSERT_TRUE(probeHash(search, keys[i], &hashMini));
+            EXPECT_EQ(i, hashMini.score);
+            EXPECT_EQ(i % 64, hashMini.depth);
+        }
+    }
+
+    // the index stays in the table at the largest UCI Hash size
+    const u64 nBucket = 262144ULL * 1024 * 1000 / sizeof(Hash::_Tbucket);
+    for (const u64 k:{0ULL, 1ULL, keys[0], 0x8000000000000000ULL, ~0ULL}) {
+        EXPECT_LT(Hash::getIndex(k, nBucket), nBucket);
+    }
+    EXPECT_EQ(nBucket - 1, Hash::getIndex(~0ULL, nBucket));
+
+    searchManager.setHashSize(hashSize);
+}
+
+#endif
@@ -37,6 +37,30 @@ TEST(perftTest, twoCore) {
     ASSERT_EQ(97862, perft->getResult());
 }
 
+TEST(perftTest, pinsAndChecks) {
+    Perft *perft = &Perft::getInstance();
+    perft->setParam("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 1, 0, "");
+    perft->start();
+    perft->join();
+    ASSERT_EQ(674624, perft->getResult());
+
+    perft->setParam("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 1, 0, "");
+    perft->start();
+    perft->join();
+    ASSERT_EQ(422333, perft->getResult());
+}
+
+TEST(perftTest, countLegalMoves) {
+    PerftThread perftThread;
+    perftThread.loadFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    ASSERT_EQ(48, perftThread.countLegalMoves());
+    perftThread.loadFen("r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1");
+    ASSERT_EQ(6, perftThread.countLegalMoves());
+    perftThread.loadFen("R5k1/5ppp/8/8/8/8/8/6K1 b - - 0 1");
+    ASSERT_EQ(0, perftThread.countLegalMoves());
+    ASSERT_EQ(2039, perftThread.perft("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 2));
+}
+
 #ifdef FULL_TEST
 TEST(perftTest, fullTest) {
     Perft *perft = &Perft::getInstance();
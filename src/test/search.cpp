@@ -39,6 +39,143 @@ TEST(search, depth1) {
     EXPECT_EQ("e1f1", it.getBestmove());
 }
 
+TEST(search, packedMove) {
+    SearchManager &searchManager = Singleton<SearchManager>::getInstance();
+    _Tmove move;
+    searchManager.loadFen("r3k2r/1P6/8/3pP3/8/8/8/R3K2R w KQkq d6 0 1");
+    // e1g1 castle, e5d6 en passant, b7a8 knight promotion
+    const _TpackedMove castle = 3 | (1 << 6) | (PACKED_CASTLE << 14);
+    const _TpackedMove enpassant = 35 | (44 << 6) | (PACKED_ENPASSANT << 14);
+    const _TpackedMove promotion = 54 | (63 << 6) | (PACKED_PROMOTION << 14);
+    for (const _TpackedMove packed:{castle, enpassant, promotion}) {
+        ASSERT_TRUE(searchManager.unpackMove(packed, &move));
+        EXPECT_EQ(packed, Search::packMove(&move));
+    }
+    EXPECT_EQ("e1g1", Search::packedMoveToString(castle));
+    EXPECT_EQ("b7a8n", Search::packedMoveToString(promotion));
+    // b7b8 without the promotion and e1g1 as a king move
+    EXPECT_FALSE(searchManager.unpackMove(54 | (62 << 6), &move));
+    EXPECT_FALSE(searchManager.unpackMove(castle & 0xfff, &move));
+    searchManager.loadFen(STARTPOS);
+}
+
+TEST(search, hashMoveLegality) {
+    SearchManager &searchManager = Singleton<SearchManager>::getInstance();
+    _Tmove move;
+    searchManager.loadFen("4k3/4r3/8/8/8/8/4B3/4K3 w - - 0 1");
+    // e2d3 moves the pinned bishop, e2e4 is not a bishop move, e1d1 is legal
+    const _TpackedMove pinned = 11 | (20 << 6);
+    ASSERT_TRUE(searchManager.isPseudoLegal(pinned, &move));
+    EXPECT_FALSE(searchManager.isLegal(&move));
+    EXPECT_FALSE(searchManager.unpackMove(pinned, &move));
+    EXPECT_FALSE(searchManager.isPseudoLegal(11 | (27 << 6), &move));
+    ASSERT_TRUE(searchManager.isPseudoLegal(3 | (4 << 6), &move));
+    EXPECT_TRUE(searchManager.isLegal(&move));
+    // the en passant capture e5d6 exposes the king to the rook on a5
+    searchManager.loadFen("4k3/8/8/r2pP1K1/8/8/8/8 w - d6 0 1");
+    const _TpackedMove enpassant = 35 | (44 << 6) | (PACKED_ENPASSANT << 14);
+    ASSERT_TRUE(searchManager.isPseudoLegal(enpassant, &move));
+    EXPECT_FALSE(searchManager.isLegal(&move));
+    searchManager.loadFen(STARTPOS);
+}
+
+TEST(search, see) {
+    GenMoves genMoves;
+    _Tmove move;
+    // e1e5 rook takes a pawn defended by a pawn
+    genMoves.loadFen("4k3/8/3p4/4p3/8/8/8/4RK2 w - - 0 1");
+    ASSERT_TRUE(genMoves.unpackMove(3 | (35 << 6), &move));
+    EXPECT_EQ(VALUEPAWN - VALUEROOK, genMoves.see<WHITE>(&move));
+    EXPECT_TRUE(genMoves.isBadCapture<WHITE>(&move));
+    // f3e5 knight takes a knight defended by a pawn
+    genMoves.loadFen("4k3/8/3p4/4n3/8/5N2/8/4K3 w - - 0 1");
+    ASSERT_TRUE(genMoves.unpackMove(18 | (35 << 6), &move));
+    EXPECT_EQ(0, genMoves.see<WHITE>(&move));
+    EXPECT_FALSE(genMoves.isBadCapture<WHITE>(&move));
+    // e2e5 rook takes a pawn defended by a rook, the rook on e1 recaptures through the x-ray
+    genMoves.loadFen("4r1k1/8/8/4p3/8/8/4R3/4R1K1 w - - 0 1");
+    ASSERT_TRUE(genMoves.unpackMove(11 | (35 << 6), &move));
+    EXPECT_EQ(VALUEPAWN, genMoves.see<WHITE>(&move));
+    EXPECT_FALSE(genMoves.isBadCapture<WHITE>(&move));
+    genMoves.loadFen("4r1k1/8/8/4p3/8/8/4R3/6K1 w - - 0 1");
+    ASSERT_TRUE(genMoves.unpackMove(11 | (35 << 6), &move));
+    EXPECT_EQ(VALUEPAWN - VALUEROOK, genMoves.see<WHITE>(&move));
+    EXPECT_TRUE(genMoves.isBadCapture<WHITE>(&move));
+    // e5d6 en passant, the rook on d1 recaptures because the pawn on d5 is taken off
+    genMoves.loadFen("3r2k1/8/8/3pP3/8/8/8/3R2K1 w - d6 0 1");
+    ASSERT_TRUE(genMoves.unpackMove(35 | (44 << 6) | (PACKED_ENPASSANT << 14), &move));
+    EXPECT_EQ(VALUEPAWN, genMoves.see<WHITE>(&move));
+    EXPECT_FALSE(genMoves.isBadCapture<WHITE>(&move));
+    // b7a8q takes a knight, the rook on b8 takes the queen
+    genMoves.loadFen("nr2k3/1P6/8/8/8/8/8/4K3 w - - 0 1");
+    ASSERT_TRUE(genMoves.unpackMove(54 | (63 << 6) | (3 << 12) | (PACKED_PROMOTION << 14), &move));
+    EXPECT_EQ(VALUEKNIGHT - VALUEPAWN, genMoves.see<WHITE>(&move));
+    EXPECT_FALSE(genMoves.isBadCapture<WHITE>(&move));
+}
+
+class MovePickerTest : public GenMoves {
+public:
+    // all the moves returned by the staged picker of the side to move
+    multiset<_TpackedMove> pickAll(const _TpackedMove hashMove, const _TpackedMove killer) {
+        return getSide() ? pickAll<WHITE>(hashMove, killer) : pickAll<BLACK>(hashMove, killer);
+    }
+
+    multiset<_TpackedMove> generateAll() {
+        return getSide() ? generateAll<WHITE>() : generateAll<BLACK>();
+    }
+
+private:
+    template<int side>
+    multiset<_TpackedMove> pickAll(const _TpackedMove hashMove, const _TpackedMove killer) {
+        multiset<_TpackedMove> res;
+        incListId();
+        killers[listId][0] = killer;
+        killers[listId][1] = NO_PACKED_MOVE;
+        _TmovePicker picker;
+        initMovePicker<side>(picker, hashMove, getAllAttackers<side>(BITScanForward(chessboard[KING_BLACK + side]), getAllPieces()));
+        _Tmove *move;
+        while ((move = getNextMove<side>(picker))) {
+            res.insert(packMove(move));
+        }
+        decListId();
+        return res;
+    }
+
+    template<int side>
+    multiset<_TpackedMove> generateAll() {
+        multiset<_TpackedMove> res;
+        incListId();
+        generateCaptures<side>(getBitmap<side ^ 1>(), getBitmap<side>());
+        generateMoves<side>(getAllPieces());
+        for (int i = 0; i < getListSize(); i++) {
+            res.insert(packMove(getMove(i)));
+        }
+        decListId();
+        return res;
+    }
+};
+
+TEST(search, movePicker) {
+    const string KIWIPETE = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+    const string ENPASSANT = "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3";
+    // {fen, hash move, killer}: e2a6 capture and a2a3, a2a3 as both, e5f6 en passant and g1f3, g1f3 and b1c3
+    const vector<tuple<string, _TpackedMove, _TpackedMove>> cases = {
+            make_tuple(KIWIPETE, 11 | (47 << 6), 15 | (23 << 6)),
+            make_tuple(KIWIPETE, 15 | (23 << 6), 15 | (23 << 6)),
+            make_tuple(KIWIPETE, NO_PACKED_MOVE, NO_PACKED_MOVE),
+            make_tuple(ENPASSANT, 35 | (42 << 6) | (PACKED_ENPASSANT << 14), 1 | (18 << 6)),
+            make_tuple(ENPASSANT, 1 | (18 << 6), 6 | (21 << 6)),
+    };
+    MovePickerTest picker;
+    for (const auto &c:cases) {
+        picker.loadFen(get<0>(c));
+        const multiset<_TpackedMove> generated = picker.generateAll();
+        picker.loadFen(get<0>(c));
+        const multiset<_TpackedMove> picked = picker.pickAll(get<1>(c), get<2>(c));
+        EXPECT_EQ(generated, picked) << get<0>(c);
+    }
+}
+
 TEST(search, twoCore) {
     const set<string> v = {"d2d4", "e2e4", "e2e3"};
     IterativeDeeping it;
@@ -24,6 +24,7 @@
 #include "spinlockShared.cpp"
 #include "spinlock.cpp"
 #include "search.cpp"
+#include "hash.cpp"
 #include "util/fileUtil.cpp"
 #include "util/string.cpp"
 #include "perft.cpp"
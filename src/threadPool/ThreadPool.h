@@ -64,15 +64,15 @@ public:
             return false;
         }
         joinAll();
-        removeAllThread();
-        nThread = t;
         ASSERT(threadsBits == 0);
-        for (int i = 0; i < nThread; i++) {
+        ///the threads already allocated are reused, only the missing ones are created
+        while ((int) threadPool.size() < t) {
             T *x = new T();
-            x->setId(i);
+            x->setId(threadPool.size());
+            x->template registerObserverThread<ThreadPool<T>>(this);
             threadPool.push_back(x);
         }
-        registerThreads();
+        nThread = t;
         trace ("ThreadPool size: ", getNthread())
         return true;
     }
@@ -138,15 +138,9 @@ private:
         releaseThread(threadID);
     }
 
-    void registerThreads() {
-        for (T *s:threadPool) {
-            s->template registerObserverThread<ThreadPool<T>>(this);
-        }
-    }
-
     void removeAllThread() {
-        joinAll();
         for (T *s:threadPool) {
+            s->join();
             delete s;
         }
         threadPool.clear();
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "../threadPool/Thread.h"
+#include <functional>
 #include <vector>
 
 class Timer : public Thread<Timer> {